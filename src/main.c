@@ -246,6 +246,24 @@ malloc_statistics_callback (ShellPerfLog *perf_log,
 #endif
 }
 
+static void
+texture_cache_statistics_callback (ShellPerfLog *perf_log,
+                                   gpointer      data)
+{
+  guint64 n_bytes;
+  guint n_entries, n_hits, n_misses, n_evictions;
+
+  st_texture_cache_get_statistics (st_texture_cache_get_default (),
+                                   &n_bytes, &n_entries,
+                                   &n_hits, &n_misses, &n_evictions);
+
+  shell_perf_log_update_statistic_x (perf_log, "textureCache.size", n_bytes);
+  shell_perf_log_update_statistic_i (perf_log, "textureCache.entries", n_entries);
+  shell_perf_log_update_statistic_i (perf_log, "textureCache.hits", n_hits);
+  shell_perf_log_update_statistic_i (perf_log, "textureCache.misses", n_misses);
+  shell_perf_log_update_statistic_i (perf_log, "textureCache.evictions", n_evictions);
+}
+
 static void
 shell_perf_log_init (void)
 {
@@ -271,6 +289,31 @@ shell_perf_log_init (void)
   shell_perf_log_add_statistics_callback (perf_log,
                                           malloc_statistics_callback,
                                           NULL, NULL);
+
+  shell_perf_log_define_statistic (perf_log,
+                                   "textureCache.size",
+                                   "Estimated size of the textures kept by StTextureCache, in bytes",
+                                   "x");
+  shell_perf_log_define_statistic (perf_log,
+                                   "textureCache.entries",
+                                   "Number of textures kept by StTextureCache",
+                                   "i");
+  shell_perf_log_define_statistic (perf_log,
+                                   "textureCache.hits",
+                                   "StTextureCache lookups that found a cached texture",
+                                   "i");
+  shell_perf_log_define_statistic (perf_log,
+                                   "textureCache.misses",
+                                   "StTextureCache lookups that had to load the texture",
+                                   "i");
+  shell_perf_log_define_statistic (perf_log,
+                                   "textureCache.evictions",
+                                   "Textures evicted by StTextureCache to stay under its size limit",
+                                   "i");
+
+  shell_perf_log_add_statistics_callback (perf_log,
+                                          texture_cache_statistics_callback,
+                                          NULL, NULL);
 }
 
 static void
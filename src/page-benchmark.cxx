@@ -0,0 +1,626 @@
+/*
+ * page-benchmark.cxx
+ *
+ * copyright (2010-2014) Benoit Gschwind
+ *
+ * This code is licensed under the GPLv3. see COPYING file for more details.
+ *
+ * Standalone benchmark of the layout engine: split and notebook trees of
+ * increasing size are laid out, split, hit-tested and rendered with the
+ * geometry of page-layout, the code used by split_t, notebook_t and
+ * workspace_t. Region merges of stacked windows and tab damage are timed
+ * too.
+ *
+ * usage: page-benchmark [page.conf]
+ *
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+
+#include <glib.h>
+
+#include "page-time.hxx"
+#include "page-region.hxx"
+#include "page-layout.hxx"
+#include "page-config-handler.hxx"
+#include "page-simple2-theme.hxx"
+
+using namespace std;
+using namespace page;
+
+/**
+ * Node of a tiling tree, a split with two children or a notebook leaf.
+ * split_t and notebook_t need a running page_t, thus only the tree
+ * bookkeeping is done here, as they do, and the geometry is page-layout.
+ **/
+struct bench_node_t {
+	bench_node_t * parent;
+	bool is_split;
+	rect allocation;
+
+	/* split_t */
+	split_type_e type;
+	double ratio;
+	unique_ptr<bench_node_t> pack0;
+	unique_ptr<bench_node_t> pack1;
+	rect bpack0;
+	rect bpack1;
+	rect split_bar_area;
+
+	/* notebook_t */
+	int tab_count;
+	rect client_area;
+	bool can_hsplit;
+	bool can_vsplit;
+	notebook_tabs_layout_t tabs;
+	vector<theme_tab_t> iconic_tabs;
+	rect button_close;
+	rect button_hsplit;
+	rect button_vsplit;
+	rect button_select;
+	rect button_exposay;
+	rect close_client;
+	rect undck_client;
+	notebook_drop_areas_t drop_areas;
+	bool drop_areas_is_valid;
+
+	bench_node_t(bench_node_t * parent, int tab_count) :
+		parent{parent}, is_split{false}, type{VERTICAL_SPLIT}, ratio{0.5},
+		tab_count{tab_count}, can_hsplit{false}, can_vsplit{false},
+		tabs{}, drop_areas_is_valid{false}
+	{ }
+
+	bench_node_t(bench_node_t * parent, split_type_e type) :
+		parent{parent}, is_split{true}, type{type}, ratio{0.5},
+		tab_count{0}, can_hsplit{false}, can_vsplit{false},
+		tabs{}, drop_areas_is_valid{false}
+	{ }
+
+};
+
+/**
+ * A viewport with its subtree and the notebook index of the workspace.
+ **/
+struct bench_viewport_t {
+	rect work_area;
+	unique_ptr<bench_node_t> subtree;
+
+	vector<bench_node_t *> notebooks;
+	rect_index_t notebook_index;
+	bool notebook_index_is_valid;
+
+	bench_viewport_t(rect const & work_area) :
+		work_area{work_area}, notebook_index_is_valid{false}
+	{ }
+
+};
+
+static void bench_min_allocation(theme_t const & theme, bench_node_t const * n,
+		int & width, int & height)
+{
+	if (not n->is_split) {
+		notebook_min_allocation(theme, width, height);
+		return;
+	}
+
+	int pack0_height = 20, pack0_width = 20;
+	int pack1_height = 20, pack1_width = 20;
+
+	if(n->pack0 != nullptr)
+		bench_min_allocation(theme, n->pack0.get(), pack0_width, pack0_height);
+	if(n->pack1 != nullptr)
+		bench_min_allocation(theme, n->pack1.get(), pack1_width, pack1_height);
+
+	split_min_allocation(theme, n->type, pack0_width, pack0_height,
+			pack1_width, pack1_height, width, height);
+}
+
+static void bench_set_allocation(theme_t const & theme, bench_node_t * n, rect const & allocation);
+
+/** as split_t::update_allocation() **/
+static void bench_update_split(theme_t const & theme, bench_node_t * n, bool skip_unchanged)
+{
+	int pack0_height = 20, pack0_width = 20;
+	int pack1_height = 20, pack1_width = 20;
+
+	if(n->pack0 != nullptr)
+		bench_min_allocation(theme, n->pack0.get(), pack0_width, pack0_height);
+	if(n->pack1 != nullptr)
+		bench_min_allocation(theme, n->pack1.get(), pack1_width, pack1_height);
+
+	auto previous_bpack0 = n->bpack0;
+	auto previous_bpack1 = n->bpack1;
+	split_children_allocation(theme, n->type, n->allocation, n->ratio,
+			pack0_width, pack0_height, pack1_width, pack1_height,
+			n->bpack0, n->bpack1);
+	n->split_bar_area = split_bar_location(theme, n->type, n->allocation, n->bpack0);
+
+	if(n->pack0 != nullptr and (not skip_unchanged or n->bpack0 != previous_bpack0))
+		bench_set_allocation(theme, n->pack0.get(), n->bpack0);
+	if(n->pack1 != nullptr and (not skip_unchanged or n->bpack1 != previous_bpack1))
+		bench_set_allocation(theme, n->pack1.get(), n->bpack1);
+}
+
+/** as notebook_t::_update_all_layout(), drop areas are computed on demand **/
+static void bench_update_notebook(theme_t const & theme, bench_node_t * n)
+{
+	notebook_client_area(theme, n->allocation, n->client_area,
+			n->can_hsplit, n->can_vsplit);
+	n->drop_areas_is_valid = false;
+
+	n->iconic_tabs.clear();
+	if (n->tab_count > 0) {
+		notebook_tabs_layout(theme, n->allocation, n->tab_count, n->tabs);
+		for (int k = 0; k < n->tab_count; ++k) {
+			n->iconic_tabs.push_back(theme_tab_t{});
+			auto & tab = n->iconic_tabs.back();
+			tab.position = notebook_iconic_tab_position(theme, k);
+			tab.title = "window title";
+			tab.tab_color = k == 0 ? theme.get_selected_color() : theme.get_normal_color();
+		}
+		notebook_selected_tab_buttons(theme, n->tabs.selected_tab,
+				n->close_client, n->undck_client);
+	}
+
+	notebook_buttons_area(theme, n->allocation, n->button_close,
+			n->button_hsplit, n->button_vsplit, n->button_select,
+			n->button_exposay);
+}
+
+static void bench_set_allocation(theme_t const & theme, bench_node_t * n, rect const & allocation)
+{
+	n->allocation = allocation;
+	if (n->is_split)
+		bench_update_split(theme, n, false);
+	else
+		bench_update_notebook(theme, n);
+}
+
+/** as split_t::set_pack0() and split_t::set_pack1() **/
+static void bench_set_pack(theme_t const & theme, bench_node_t * split, int pack, unique_ptr<bench_node_t> x)
+{
+	x->parent = split;
+	(pack == 0 ? split->pack0 : split->pack1) = std::move(x);
+	bench_update_split(theme, split, false);
+}
+
+/**
+ * Split a notebook as page_t::split_right() and page_t::split_bottom() do,
+ * including the intermediate layouts of replace(), set_pack0() and
+ * set_pack1().
+ **/
+static void bench_split(theme_t const & theme, bench_viewport_t & vp, bench_node_t * nbk, split_type_e type)
+{
+	auto parent = nbk->parent;
+	unique_ptr<bench_node_t> split{new bench_node_t{parent, type}};
+	unique_ptr<bench_node_t> n{new bench_node_t{nullptr, nbk->tab_count}};
+	auto s = split.get();
+
+	unique_ptr<bench_node_t> old;
+	if (parent == nullptr) {
+		old = std::move(vp.subtree);
+		vp.subtree = std::move(split);
+		bench_set_allocation(theme, s, rect(0, 0, vp.work_area.w, vp.work_area.h));
+	} else {
+		int pack = parent->pack0.get() == nbk ? 0 : 1;
+		old = std::move(pack == 0 ? parent->pack0 : parent->pack1);
+		bench_set_pack(theme, parent, pack, std::move(split));
+		bench_update_split(theme, parent, false);
+	}
+
+	bench_set_pack(theme, s, 0, std::move(old));
+	bench_set_pack(theme, s, 1, std::move(n));
+	vp.notebook_index_is_valid = false;
+}
+
+static void bench_notebooks(bench_node_t * n, vector<bench_node_t *> & notebooks)
+{
+	if (not n->is_split) {
+		notebooks.push_back(n);
+		return;
+	}
+	bench_notebooks(n->pack0.get(), notebooks);
+	bench_notebooks(n->pack1.get(), notebooks);
+}
+
+struct bench_split_step_t {
+	int notebook;
+	split_type_e type;
+};
+
+/**
+ * Split the largest notebook that can be split until count notebooks
+ * exist or none can be split, return the sequence of splits.
+ **/
+static auto bench_grow(theme_t const & theme, bench_viewport_t & vp, int count) -> vector<bench_split_step_t>
+{
+	vector<bench_split_step_t> steps;
+	vector<bench_node_t *> notebooks;
+	for (int k = 1; k < count; ++k) {
+		notebooks.clear();
+		bench_notebooks(vp.subtree.get(), notebooks);
+
+		int best = -1;
+		for (int i = 0; i < static_cast<int>(notebooks.size()); ++i) {
+			auto n = notebooks[i];
+			if (not n->can_hsplit and not n->can_vsplit)
+				continue;
+			auto const & a = n->allocation;
+			if (best < 0 or a.w * a.h > notebooks[best]->allocation.w * notebooks[best]->allocation.h)
+				best = i;
+		}
+
+		if (best < 0)
+			break;
+
+		auto n = notebooks[best];
+		auto type = n->can_vsplit and (n->allocation.w >= n->allocation.h or not n->can_hsplit)
+				? VERTICAL_SPLIT : HORIZONTAL_SPLIT;
+		steps.push_back(bench_split_step_t{best, type});
+		bench_split(theme, vp, n, type);
+	}
+	return steps;
+}
+
+/** build the tree from a single notebook, replaying splits **/
+static void bench_build(theme_t const & theme, bench_viewport_t & vp, int tab_count, vector<bench_split_step_t> const & steps)
+{
+	vp.subtree.reset(new bench_node_t{nullptr, tab_count});
+	bench_set_allocation(theme, vp.subtree.get(), rect(0, 0, vp.work_area.w, vp.work_area.h));
+
+	vector<bench_node_t *> notebooks;
+	for (auto const & s: steps) {
+		notebooks.clear();
+		bench_notebooks(vp.subtree.get(), notebooks);
+		bench_split(theme, vp, notebooks[s.notebook], s.type);
+	}
+
+	vp.notebooks.clear();
+	bench_notebooks(vp.subtree.get(), vp.notebooks);
+	vp.notebook_index_is_valid = false;
+}
+
+/** as split_t::pointer_target() and notebook_t::pointer_target() **/
+static auto bench_pointer_target(bench_node_t * n, int x, int y) -> bench_node_t *
+{
+	if (not n->is_split)
+		return n->allocation.is_inside(x, y) ? n : nullptr;
+	if (n->split_bar_area.is_inside(x, y))
+		return n;
+	if (n->pack0 != nullptr and n->pack0->allocation.is_inside(x, y))
+		return bench_pointer_target(n->pack0.get(), x, y);
+	if (n->pack1 != nullptr and n->pack1->allocation.is_inside(x, y))
+		return bench_pointer_target(n->pack1.get(), x, y);
+	return nullptr;
+}
+
+static auto bench_root_area(bench_viewport_t const & vp, bench_node_t const * n) -> rect
+{
+	rect area = n->allocation;
+	area.x += vp.work_area.x;
+	area.y += vp.work_area.y;
+	return area;
+}
+
+/** as notebook_index_t::update() **/
+static void bench_update_index(bench_viewport_t & vp)
+{
+	vector<rect> areas;
+	for (auto n: vp.notebooks)
+		areas.push_back(bench_root_area(vp, n));
+	vp.notebook_index.update(areas);
+	vp.notebook_index_is_valid = true;
+}
+
+/** as the _find_target_notebook() of view grabs **/
+static auto bench_drop_zone(theme_t const & theme, bench_viewport_t & vp, int x, int y) -> notebook_area_e
+{
+	if (not vp.notebook_index_is_valid)
+		bench_update_index(vp);
+
+	int id = vp.notebook_index.lookup(x, y);
+	if (id < 0)
+		return NOTEBOOK_AREA_NONE;
+
+	auto n = vp.notebooks[id];
+	if (not n->drop_areas_is_valid) {
+		notebook_drop_areas(theme, bench_root_area(vp, n), n->can_hsplit,
+				n->can_vsplit, n->drop_areas);
+		n->drop_areas_is_valid = true;
+	}
+
+	return notebook_drop_zone(n->drop_areas, x, y);
+}
+
+/**
+ * Render as split_t::render_legacy() and notebook_t::render_legacy(),
+ * iconic tabs are drawn as when their cache is invalid.
+ **/
+static void bench_render(theme_t const & theme, cairo_t * cr, bench_node_t const * n)
+{
+	if (n->is_split) {
+		theme_split_t ts;
+		ts.split = n->ratio;
+		ts.type = n->type;
+		ts.allocation = n->split_bar_area;
+		ts.root_x = 0;
+		ts.root_y = 0;
+		ts.has_mouse_over = false;
+		theme.render_split(cr, &ts);
+		bench_render(theme, cr, n->pack0.get());
+		bench_render(theme, cr, n->pack1.get());
+		return;
+	}
+
+	theme_notebook_t tn;
+	tn.allocation = n->allocation;
+	tn.client_position = n->client_area;
+	tn.client_count = n->tab_count;
+	tn.can_hsplit = n->can_hsplit;
+	tn.can_vsplit = n->can_vsplit;
+	if (n->tab_count > 0) {
+		tn.has_selected_client = true;
+		tn.selected_client.position = n->tabs.selected_tab;
+		tn.selected_client.title = "selected window title";
+		tn.selected_client.tab_color = theme.get_selected_color();
+		tn.has_scroll_arrow = n->tabs.has_scroll_arrow;
+		tn.left_arrow_position = n->tabs.left_scroll_arrow;
+		tn.right_arrow_position = n->tabs.right_scroll_arrow;
+	}
+	theme.render_notebook(cr, &tn);
+
+	if (not n->iconic_tabs.empty()) {
+		cairo_save(cr);
+		cairo_clip(cr, n->tabs.tabs_area);
+		cairo_translate(cr, n->tabs.tabs_area.x, n->tabs.tabs_area.y);
+		theme.render_iconic_notebook(cr, n->iconic_tabs);
+		cairo_restore(cr);
+	}
+}
+
+static void bench_areas(bench_node_t const * n, vector<rect> & areas)
+{
+	if (not n->is_split) {
+		areas.push_back(n->allocation);
+		return;
+	}
+	areas.push_back(n->split_bar_area);
+	bench_areas(n->pack0.get(), areas);
+	bench_areas(n->pack1.get(), areas);
+}
+
+/** results of pure queries are stored here to keep them alive **/
+static int volatile bench_sink;
+
+static unsigned bench_seed = 1;
+
+static int bench_random(int n)
+{
+	bench_seed = bench_seed * 1103515245u + 12345u;
+	return (bench_seed >> 8) % n;
+}
+
+/**
+ * Overlapping windows at random positions, bottom first.
+ **/
+static auto bench_windows(rect const & area, int count) -> vector<rect>
+{
+	vector<rect> ret;
+	for(int k = 0; k < count; ++k) {
+		int w = area.w / 8 + bench_random(area.w / 2);
+		int h = area.h / 8 + bench_random(area.h / 2);
+		ret.push_back(rect(area.x + bench_random(area.w - w), area.y + bench_random(area.h - h), w, h));
+	}
+	return ret;
+}
+
+/**
+ * Two interleaved rows of tab damage, the walls of a and b alternate
+ * within a single band.
+ **/
+static void bench_tab_damage(int tab_count, region & a, region & b)
+{
+	vector<rect> ra;
+	vector<rect> rb;
+	for(int k = 0; k < tab_count; ++k) {
+		(k % 2 ? rb : ra).push_back(rect(k * 30, 0, 20, 24));
+		(k % 2 ? ra : rb).push_back(rect(k * 30 + 10, 0, 15, 24));
+	}
+	a = region::from_rects(ra);
+	b = region::from_rects(rb);
+}
+
+/**
+ * Run f enough times to last at least 100ms and print the average time.
+ **/
+static void bench_run(char const * name, int scale, function<void()> f)
+{
+	int iterations = 0;
+	time64_t start = time64_t::now();
+	time64_t elapsed;
+	do {
+		f();
+		++iterations;
+		elapsed = time64_t::now() - start;
+	} while (static_cast<int64_t>(elapsed) < 100000000L);
+
+	printf("%-24s %6d %12.3f us\n", name, scale,
+			static_cast<double>(elapsed) / iterations / 1000.0);
+}
+
+/**
+ * The background is decoded in a thread and delivered through the main
+ * context, wait for it, for at most 10s.
+ **/
+static void bench_wait_background(simple2_theme_t const & theme)
+{
+	if (not theme.has_background)
+		return;
+
+	bool timeout = false;
+	auto id = g_timeout_add_seconds(10, [](gpointer data) -> gboolean {
+		*reinterpret_cast<bool *>(data) = true;
+		return G_SOURCE_REMOVE;
+	}, &timeout);
+
+	while (theme.get_background() == nullptr and not timeout)
+		g_main_context_iteration(nullptr, TRUE);
+
+	if (timeout)
+		fprintf(stderr, "background not ready, rendering without it\n");
+	else
+		g_source_remove(id);
+}
+
+int main(int argc, char ** argv)
+{
+	string conf_file = PAGE_BENCHMARK_CONF;
+	if (argc > 1)
+		conf_file = argv[1];
+
+	/* theme loading is verbose */
+	log::set_file("/dev/null");
+
+	config_handler_t conf;
+	conf.merge_from_file_if_exist(conf_file);
+	simple2_theme_t theme{conf};
+
+	rect screen{0, 0, 1920, 1080};
+	theme.update(screen.w, screen.h);
+	bench_wait_background(theme);
+
+	cairo_surface_t * offscreen = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, screen.w, screen.h);
+	cairo_t * cr = cairo_create(offscreen);
+
+	/* pointer positions for hit-tests, queried 1024 per iteration */
+	vector<pair<int, int>> points;
+	for (int k = 0; k < 1024; ++k)
+		points.push_back(make_pair(bench_random(screen.w), bench_random(screen.h)));
+
+	printf("%-24s %6s %15s\n", "benchmark", "scale", "time/iteration");
+
+	for (int count: {1, 4, 16, 64}) {
+		bench_viewport_t vp{screen};
+		bench_build(theme, vp, 8, {});
+		auto steps = bench_grow(theme, vp, count);
+		bench_build(theme, vp, 8, steps);
+		int notebooks = vp.notebooks.size();
+
+		bench_run("split (build tree)", notebooks, [&]() {
+			bench_build(theme, vp, 8, steps);
+		});
+
+		bench_run("layout", notebooks, [&]() {
+			bench_set_allocation(theme, vp.subtree.get(), rect(0, 0, screen.w, screen.h));
+			vp.notebook_index_is_valid = false;
+		});
+
+		if (vp.subtree->is_split) {
+			/* as split_t::set_split() while dragging the root split bar */
+			bench_run("layout (ratio)", notebooks, [&]() {
+				auto root = vp.subtree.get();
+				root->ratio = root->ratio < 0.5 ? 0.55 : 0.45;
+				bench_update_split(theme, root, true);
+				vp.notebook_index_is_valid = false;
+			});
+			vp.subtree->ratio = 0.5;
+			bench_set_allocation(theme, vp.subtree.get(), rect(0, 0, screen.w, screen.h));
+		}
+
+		bench_run("pointer target (x1024)", notebooks, [&]() {
+			int hits = 0;
+			for (auto const & p: points)
+				hits += bench_pointer_target(vp.subtree.get(), p.first, p.second) != nullptr;
+			bench_sink = hits;
+		});
+
+		bench_run("notebook index", notebooks, [&]() {
+			bench_update_index(vp);
+		});
+
+		bench_run("drop zone (x1024)", notebooks, [&]() {
+			int zones = 0;
+			for (auto const & p: points)
+				zones += bench_drop_zone(theme, vp, p.first, p.second);
+			bench_sink = zones;
+		});
+
+		vector<rect> rects;
+		bench_areas(vp.subtree.get(), rects);
+
+		bench_run("region union (+=)", notebooks, [&]() {
+			region r;
+			for (auto const & x: rects)
+				r += region{x};
+		});
+
+		bench_run("region union (builder)", notebooks, [&]() {
+			region::from_rects(rects);
+		});
+
+		bench_run("region visibility", notebooks, [&]() {
+			region r{screen};
+			for (auto const & x: rects)
+				r -= region{x};
+		});
+
+		for (int tabs: {8, 64}) {
+			bench_build(theme, vp, tabs, steps);
+			bench_run(tabs == 8 ? "render (8 tabs)" : "render (64 tabs)", notebooks, [&]() {
+				bench_render(theme, cr, vp.subtree.get());
+				cairo_surface_flush(offscreen);
+			});
+		}
+	}
+
+	for (int monitors: {1, 2, 4, 8}) {
+		/* every monitor overlap the half of the previous one */
+		vector<rect> work_areas;
+		for (int k = 0; k < monitors; ++k)
+			work_areas.push_back(rect(k * screen.w / 2, 0, screen.w, screen.h));
+
+		bench_run("viewports allocation", monitors, [&]() {
+			viewports_allocation(work_areas);
+		});
+	}
+
+	for(int windows: {8, 32, 128}) {
+		auto stack = bench_windows(screen, windows);
+
+		/* the visible part of each window, as for opaque regions */
+		bench_run("region window stack", windows, [&]() {
+			region above;
+			for(auto k = stack.rbegin(); k != stack.rend(); ++k) {
+				region visible = region{*k} - above;
+				above += region{*k};
+			}
+		});
+	}
+
+	for(int tabs: {8, 64, 256}) {
+		region a, b;
+		bench_tab_damage(tabs, a, b);
+
+		bench_run("region merge (+)", tabs, [&]() {
+			region r = a + b;
+		});
+
+		bench_run("region merge (-)", tabs, [&]() {
+			region r = a - b;
+		});
+
+		bench_run("region merge (&)", tabs, [&]() {
+			region r = a & b;
+		});
+	}
+
+	cairo_destroy(cr);
+	cairo_surface_destroy(offscreen);
+
+	return 0;
+}
@@ -27,6 +27,7 @@ client_managed_t::client_managed_t(page_t * ctx, MetaWindowActor * actor) :
 	_meta_window{meta_window_actor_get_meta_window(actor)},
 	_floating_wished_position{},
 	_absolute_position{},
+	_move_resize_pending{false},
 	_current_owner_view{nullptr}
 {
 	g_object_ref(_meta_window_actor);
@@ -84,6 +85,7 @@ void client_managed_t::_handler_meta_window_raised(MetaWindow * metawindow)
 	log::printf("call %s\n", __PRETTY_FUNCTION__);
 
 	/* ensure preservation of stack */
+	_ctx->notify_client_raised(this);
 	_ctx->sync_tree_view();
 }
 
@@ -63,6 +63,9 @@ struct client_managed_t :
 	 **/
 	rect _absolute_position;
 
+	/** _absolute_position must be applied to the MetaWindow at next frame **/
+	bool _move_resize_pending;
+
 	view_t * _current_owner_view;
 
 	/* private to avoid copy */
@@ -53,6 +53,14 @@ struct color_t {
 		b = ((color >> 0) & 0x000000ff) / 255.0;
 	}
 
+	bool operator==(color_t const & x) const {
+		return r == x.r and g == x.g and b == x.b and a == x.a;
+	}
+
+	bool operator!=(color_t const & x) const {
+		return not (*this == x);
+	}
+
 	color_t operator*(double f) const {
 		color_t ret{*this};
 		ret.r *= f;
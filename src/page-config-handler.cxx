@@ -98,6 +98,20 @@ bool config_handler_t::has_key(char const * group, char const * key) const {
 	return true;
 }
 
+bool config_handler_t::same_group(config_handler_t const & x, char const * group) const {
+	auto lower = [group](std::map<_key_t, std::string> const & data) {
+		return data.lower_bound(_key_t(group, std::string{}));
+	};
+
+	auto i = lower(_data);
+	auto j = lower(x._data);
+	for (; i != _data.end() and i->first.first == group; ++i, ++j) {
+		if (j == x._data.end() or j->first != i->first or j->second != i->second)
+			return false;
+	}
+	return j == x._data.end() or j->first.first != group;
+}
+
 std::string const & config_handler_t::find(char const * group, char const * key) const {
 	auto x = _data.find(_key_t(group, key));
 	if(x == _data.end())
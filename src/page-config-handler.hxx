@@ -31,6 +31,9 @@ public:
 
 	bool has_key(char const * groups, char const * key) const;
 
+	/** true if both configurations hold the same keys and values in group **/
+	bool same_group(config_handler_t const & x, char const * group) const;
+
 	std::string get_string(char const * groups, char const * key) const;
 	double get_double(char const * groups, char const * key) const;
 	long get_long(char const * group, char const * key) const;
@@ -137,7 +137,7 @@ xcb_timestamp_t dropdown_menu_t::time()
 
 void dropdown_menu_t::draw(ClutterCanvas * canvas, cairo_t * cr, int width, int height)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MENU, "call %s\n", __PRETTY_FUNCTION__);
 	for (unsigned k = 0; k < _items.size(); ++k) {
 		update_items_back_buffer(cr, k);
 	}
@@ -169,13 +169,13 @@ void dropdown_menu_t::update_cursor_position(int x, int y)
 
 void dropdown_menu_t::button_press(ClutterEvent const * e)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MENU, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 
 void dropdown_menu_t::button_motion(ClutterEvent const * e)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MENU, "call %s\n", __PRETTY_FUNCTION__);
 	gfloat x, y;
 	clutter_event_get_coords(e, &x, &y);
 	update_cursor_position(x, y);
@@ -183,13 +183,13 @@ void dropdown_menu_t::button_motion(ClutterEvent const * e)
 
 void dropdown_menu_t::button_release(ClutterEvent const * e)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MENU, "call %s\n", __PRETTY_FUNCTION__);
 	gfloat x, y;
 	clutter_event_get_coords(e, &x, &y);
 	auto button = clutter_event_get_button(e);
 	auto time = clutter_event_get_time(e);
 
-	log::printf("button=%d\n", button);
+	log(LOG_MENU, "button=%d\n", button);
 
 	if(not pop->_position.is_inside(x, y)) {
 		if(has_been_released) {
@@ -210,7 +210,7 @@ void dropdown_menu_t::key_release(ClutterEvent const * ev) {
 	auto key = clutter_event_get_key_symbol(ev);
 	auto time = clutter_event_get_time(ev);
 
-	log::printf("key release = %d, %d\n", key, XK_Escape);
+	log(LOG_MENU, "key release = %d, %d\n", key, XK_Escape);
 
 	if (key == XK_Escape) {
 		_ctx->grab_stop(time);
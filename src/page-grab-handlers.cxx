@@ -20,14 +20,19 @@ namespace page {
 using namespace std;
 
 grab_default_t::grab_default_t(page_t * c) :
-	_ctx{c}
+	_ctx{c},
+	_pending_motion{nullptr},
+	_motion_repaint_func_id{0}
 {
 
 }
 
 grab_default_t::~grab_default_t()
 {
-
+	if (_motion_repaint_func_id != 0)
+		clutter_threads_remove_repaint_func(_motion_repaint_func_id);
+	if (_pending_motion != nullptr)
+		clutter_event_free(_pending_motion);
 }
 
 void grab_default_t::button_press(ClutterEvent const * e)
@@ -36,10 +41,44 @@ void grab_default_t::button_press(ClutterEvent const * e)
 }
 
 void grab_default_t::button_motion(ClutterEvent const * e)
+{
+	if (_pending_motion != nullptr)
+		clutter_event_free(_pending_motion);
+	_pending_motion = clutter_event_copy(e);
+
+	if (_motion_repaint_func_id == 0) {
+		_motion_repaint_func_id = clutter_threads_add_repaint_func_full(
+				CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+				&grab_default_t::_motion_repaint_func, this, nullptr);
+		_ctx->schedule_repaint();
+	}
+}
+
+void grab_default_t::apply_motion(ClutterEvent const * e)
 {
 
 }
 
+/**
+ * Apply the latest motion, the grab may be stopped and this deleted within
+ * apply_motion(), thus nothing must be accessed after it.
+ **/
+gboolean grab_default_t::_motion_repaint_func(gpointer data)
+{
+	auto grab = reinterpret_cast<grab_default_t *>(data);
+	auto e = grab->_pending_motion;
+	grab->_pending_motion = nullptr;
+	/* returning FALSE remove the repaint func */
+	grab->_motion_repaint_func_id = 0;
+
+	if (e != nullptr) {
+		grab->apply_motion(e);
+		clutter_event_free(e);
+	}
+
+	return FALSE;
+}
+
 void grab_default_t::button_release(ClutterEvent const * e)
 {
 
@@ -68,23 +107,17 @@ grab_split_t::grab_split_t(page_t * ctx, shared_ptr<split_t> s) : grab_default_t
 	_slider_area = s->to_root_position(s->get_split_bar_area());
 	_split_ratio = s->ratio();
 	_split_root_allocation = s->root_location();
-	_ps = make_shared<popup_split_t>(s.get(), s);
-	_ctx->overlay_add(_ps);
-	_ps->show();
 }
 
 grab_split_t::~grab_split_t() {
-	if(_ps != nullptr) {
-		_ctx->schedule_repaint();
-		_ps->detach_myself();
-	}
+
 }
 
 void grab_split_t::button_press(ClutterEvent const * e) {
 	/* ignore */
 }
 
-void grab_split_t::button_motion(ClutterEvent const * e)
+void grab_split_t::apply_motion(ClutterEvent const * e)
 {
 	gfloat x, y;
 	clutter_event_get_coords(e, &x, &y);
@@ -108,8 +141,8 @@ void grab_split_t::button_motion(ClutterEvent const * e)
 
 	_split_ratio = _split.lock()->compute_split_constaint(_split_ratio);
 
-	_ps->set_position(_split_ratio);
-	_ctx->schedule_repaint();
+	/* live resize, only children with a new allocation are laid out */
+	_split.lock()->set_split(_split_ratio);
 
 }
 
@@ -182,41 +215,22 @@ void grab_bind_view_notebook_t::_find_target_notebook(int x, int y,
 	zone = NOTEBOOK_AREA_NONE;
 
 	/* place the popup */
-	auto ln = workspace->gather_children_root_first<notebook_t>();
-	for (auto i : ln) {
-		if (i->_area.tab.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_TAB;
-			target = i;
-			break;
-		} else if (i->_area.right.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_RIGHT;
-			target = i;
-			break;
-		} else if (i->_area.top.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_TOP;
-			target = i;
-			break;
-		} else if (i->_area.bottom.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_BOTTOM;
-			target = i;
-			break;
-		} else if (i->_area.left.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_LEFT;
-			target = i;
-			break;
-		} else if (i->_area.popup_center.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_CENTER;
-			target = i;
-			break;
-		}
-	}
+	auto i = workspace->notebook_at(x, y);
+	if (i == nullptr)
+		return;
+
+	i->_update_drop_areas();
+	zone = notebook_drop_zone(i->_area, x, y);
+
+	if (zone != NOTEBOOK_AREA_NONE)
+		target = i->shared_from_this();
 }
 
 void grab_bind_view_notebook_t::button_press(ClutterEvent const * e) {
 
 }
 
-void grab_bind_view_notebook_t::button_motion(ClutterEvent const * e)
+void grab_bind_view_notebook_t::apply_motion(ClutterEvent const * e)
 {
 	gfloat x, y;
 	clutter_event_get_coords(e, &x, &y);
@@ -309,7 +323,7 @@ void grab_bind_view_notebook_t::button_release(ClutterEvent const * e)
 			return;
 		}
 
-		switch(zone) {
+		switch(new_zone) {
 		case NOTEBOOK_AREA_TAB:
 		case NOTEBOOK_AREA_CENTER:
 			if(new_target != c->parent_notebook()) {
@@ -360,41 +374,22 @@ void grab_bind_view_floating_t::_find_target_notebook(int x, int y,
 	zone = NOTEBOOK_AREA_NONE;
 
 	/* place the popup */
-	auto ln = _ctx->current_workspace()->gather_children_root_first<notebook_t>();
-	for (auto i : ln) {
-		if (i->_area.tab.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_TAB;
-			target = i;
-			break;
-		} else if (i->_area.right.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_RIGHT;
-			target = i;
-			break;
-		} else if (i->_area.top.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_TOP;
-			target = i;
-			break;
-		} else if (i->_area.bottom.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_BOTTOM;
-			target = i;
-			break;
-		} else if (i->_area.left.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_LEFT;
-			target = i;
-			break;
-		} else if (i->_area.popup_center.is_inside(x, y)) {
-			zone = NOTEBOOK_AREA_CENTER;
-			target = i;
-			break;
-		}
-	}
+	auto i = _ctx->current_workspace()->notebook_at(x, y);
+	if (i == nullptr)
+		return;
+
+	i->_update_drop_areas();
+	zone = notebook_drop_zone(i->_area, x, y);
+
+	if (zone != NOTEBOOK_AREA_NONE)
+		target = i->shared_from_this();
 }
 
 void grab_bind_view_floating_t::button_press(ClutterEvent const * e) {
 
 }
 
-void grab_bind_view_floating_t::button_motion(ClutterEvent const * e)
+void grab_bind_view_floating_t::apply_motion(ClutterEvent const * e)
 {
 	gfloat x, y;
 	clutter_event_get_coords(e, &x, &y);
@@ -475,7 +470,7 @@ void grab_bind_view_floating_t::button_release(ClutterEvent const * e)
 			return;
 		}
 
-		switch(zone) {
+		switch(new_zone) {
 		case NOTEBOOK_AREA_TAB:
 		case NOTEBOOK_AREA_CENTER:
 			_ctx->move_floating_to_notebook(c, new_target, time);
@@ -9,27 +9,31 @@
 #define SRC_GRAB_HANDLERS_HXX_
 
 #include "page-split.hxx"
+#include "page-layout.hxx"
 #include "page-workspace.hxx"
-#include "page-popup-split.hxx"
 
 
 namespace page {
 
 using namespace std;
 
-enum notebook_area_e {
-	NOTEBOOK_AREA_NONE,
-	NOTEBOOK_AREA_TAB,
-	NOTEBOOK_AREA_TOP,
-	NOTEBOOK_AREA_BOTTOM,
-	NOTEBOOK_AREA_LEFT,
-	NOTEBOOK_AREA_RIGHT,
-	NOTEBOOK_AREA_CENTER
-};
-
+/**
+ * Default grab, motion events are coalesced and only the latest one is
+ * applied through apply_motion() once per frame, before the stage paint.
+ **/
 struct grab_default_t : public grab_handler_t {
 	page_t * _ctx;
 
+private:
+	ClutterEvent * _pending_motion;
+	guint _motion_repaint_func_id;
+
+	static gboolean _motion_repaint_func(gpointer data);
+
+protected:
+	virtual void apply_motion(ClutterEvent const * e);
+
+public:
 	grab_default_t(page_t * c);
 
 	virtual ~grab_default_t();
@@ -45,14 +49,13 @@ class grab_split_t : public grab_default_t {
 	rect _slider_area;
 	rect _split_root_allocation;
 	double _split_ratio;
-	shared_ptr<popup_split_t> _ps;
 
 public:
 	grab_split_t(page_t * ctx, shared_ptr<split_t> s);
 
 	virtual ~grab_split_t();
 	virtual void button_press(ClutterEvent const * e) override;
-	virtual void button_motion(ClutterEvent const * e) override;
+	virtual void apply_motion(ClutterEvent const * e) override;
 	virtual void button_release(ClutterEvent const * e) override;
 	using grab_handler_t::key_press;
 	using grab_handler_t::key_release;
@@ -77,7 +80,7 @@ public:
 
 	virtual ~grab_bind_view_notebook_t();
 	virtual void button_press(ClutterEvent const * e) override;
-	virtual void button_motion(ClutterEvent const * e) override;
+	virtual void apply_motion(ClutterEvent const * e) override;
 	virtual void button_release(ClutterEvent const * e) override;
 	using grab_handler_t::key_press;
 	using grab_handler_t::key_release;
@@ -99,7 +102,7 @@ public:
 
 	virtual ~grab_bind_view_floating_t();
 	virtual void button_press(ClutterEvent const * e) override;
-	virtual void button_motion(ClutterEvent const * e) override;
+	virtual void apply_motion(ClutterEvent const * e) override;
 	virtual void button_release(ClutterEvent const * e) override;
 	using grab_handler_t::key_press;
 	using grab_handler_t::key_release;
@@ -0,0 +1,457 @@
+/*
+ * page-layout.cxx
+ *
+ * copyright (2010-2014) Benoit Gschwind
+ *
+ * This code is licensed under the GPLv3. see COPYING file for more details.
+ *
+ */
+
+#include "page-layout.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+#include "page-region.hxx"
+
+namespace page {
+
+using namespace std;
+
+void split_min_allocation(theme_t const & theme, split_type_e type,
+		int width0, int height0, int width1, int height1,
+		int & width, int & height)
+{
+	if (type == VERTICAL_SPLIT) {
+		width = width0 + width1 + theme.split.width;
+		height = std::max(height0, height1);
+	} else {
+		width = std::max(width0, width1);
+		height = height0 + height1 + theme.split.width;
+	}
+}
+
+void split_children_allocation(theme_t const & theme, split_type_e type,
+		rect const & allocation, double split,
+		int width0, int height0, int width1, int height1,
+		rect & bpack0, rect & bpack1)
+{
+	auto const & margin = theme.split.margin;
+
+	if (type == VERTICAL_SPLIT) {
+
+		int w = allocation.w - 2 * margin.left - 2 * margin.right
+				- theme.split.width;
+
+		int w0 = floor(w * split + 0.5);
+		int w1 = w - w0;
+
+		if(w0 < width0) {
+			w1 -= width0 - w0;
+			w0 = width0;
+		}
+
+		if(w1 < width1) {
+			w0 -= width1 - w1;
+			w1 = width1;
+		}
+
+		bpack0.x = allocation.x + margin.left;
+		bpack0.y = allocation.y + margin.top;
+		bpack0.w = w0;
+		bpack0.h = allocation.h - margin.top - margin.bottom;
+
+		bpack1.x = allocation.x + margin.left + w0 + margin.right
+				+ theme.split.width + margin.left;
+		bpack1.y = allocation.y + margin.top;
+		bpack1.w = w1;
+		bpack1.h = allocation.h - margin.top - margin.bottom;
+
+	} else {
+
+		int h = allocation.h - 2 * margin.top - 2 * margin.bottom
+				- theme.split.width;
+
+		int h0 = floor(h * split + 0.5);
+		int h1 = h - h0;
+
+		if(h0 < height0) {
+			h1 -= height0 - h0;
+			h0 = height0;
+		}
+
+		if(h1 < height1) {
+			h0 -= height1 - h1;
+			h1 = height1;
+		}
+
+		bpack0.x = allocation.x + margin.left;
+		bpack0.y = allocation.y + margin.top;
+		bpack0.w = allocation.w - margin.left - margin.right;
+		bpack0.h = h0;
+
+		bpack1.x = allocation.x + margin.left;
+		bpack1.y = allocation.y + margin.top + h0 + margin.bottom
+				+ theme.split.width + margin.top;
+		bpack1.w = allocation.w - margin.left - margin.right;
+		bpack1.h = h1;
+
+	}
+}
+
+auto split_bar_location(theme_t const & theme, split_type_e type,
+		rect const & allocation, rect const & bpack0) -> rect
+{
+	auto const & margin = theme.split.margin;
+
+	rect ret;
+	if (type == VERTICAL_SPLIT) {
+		ret.x = allocation.x + margin.left + bpack0.w;
+		ret.y = allocation.y;
+		ret.w = theme.split.width + margin.left + margin.right;
+		ret.h = allocation.h;
+	} else {
+		ret.x = allocation.x;
+		ret.y = allocation.y + margin.top + bpack0.h;
+		ret.w = allocation.w;
+		ret.h = theme.split.width + margin.top + margin.bottom;
+	}
+	return ret;
+}
+
+void notebook_min_allocation(theme_t const & theme, int & width, int & height)
+{
+	height = theme.notebook.tab_height
+			+ theme.notebook.margin.top
+			+ theme.notebook.margin.bottom + 20;
+	width = theme.notebook.margin.left
+			+ theme.notebook.margin.right + 100
+			+ theme.notebook.close_width
+			+ theme.notebook.selected_close_width
+			+ theme.notebook.selected_unbind_width
+			+ theme.notebook.vsplit_width
+			+ theme.notebook.hsplit_width
+			+ theme.notebook.mark_width
+			+ theme.notebook.menu_button_width
+			+ theme.notebook.iconic_tab_width * 4;
+}
+
+void notebook_client_area(theme_t const & theme, rect const & allocation,
+		rect & client_area, bool & can_hsplit, bool & can_vsplit)
+{
+	int min_width;
+	int min_height;
+	notebook_min_allocation(theme, min_width, min_height);
+
+	can_vsplit = allocation.w >= min_width * 2 + theme.split.margin.left
+			+ theme.split.margin.right + theme.split.width;
+	can_hsplit = allocation.h >= min_height * 2 + theme.split.margin.top
+			+ theme.split.margin.bottom + theme.split.width;
+
+	client_area.x = allocation.x + theme.notebook.margin.left;
+	client_area.y = allocation.y + theme.notebook.margin.top + theme.notebook.tab_height;
+	client_area.w = allocation.w - theme.notebook.margin.left - theme.notebook.margin.right;
+	client_area.h = allocation.h - theme.notebook.margin.top - theme.notebook.margin.bottom - theme.notebook.tab_height;
+
+	if(client_area.w <= 0) {
+		client_area.w = 1;
+	}
+
+	if(client_area.h <= 0) {
+		client_area.h = 1;
+	}
+}
+
+void notebook_buttons_area(theme_t const & theme, rect const & allocation,
+		rect & close, rect & hsplit, rect & vsplit, rect & bookmark,
+		rect & menu)
+{
+	int right = allocation.x + allocation.w;
+	int tab_height = theme.notebook.tab_height;
+
+	close = rect(right - theme.notebook.close_width, allocation.y,
+			theme.notebook.close_width, tab_height);
+	hsplit = rect(close.x - theme.notebook.hsplit_width, allocation.y,
+			theme.notebook.hsplit_width, tab_height);
+	vsplit = rect(hsplit.x - theme.notebook.vsplit_width, allocation.y,
+			theme.notebook.vsplit_width, tab_height);
+	bookmark = rect(vsplit.x - theme.notebook.mark_width, allocation.y,
+			theme.notebook.mark_width, tab_height);
+	menu = rect(allocation.x, allocation.y,
+			theme.notebook.menu_button_width, tab_height);
+}
+
+void notebook_tabs_layout(theme_t const & theme, rect const & allocation,
+		int tab_count, notebook_tabs_layout_t & layout)
+{
+	int buttons_width = (int)theme.notebook.close_width
+			+ (int)theme.notebook.hsplit_width
+			+ (int)theme.notebook.vsplit_width
+			+ (int)theme.notebook.mark_width
+			+ (int)theme.notebook.menu_button_width;
+
+	int selected_box_width = (int)allocation.w - buttons_width
+			- tab_count * (int)theme.notebook.iconic_tab_width;
+
+	if(selected_box_width < 200) {
+		selected_box_width = 200;
+	}
+
+	layout.selected_tab = rect(
+			allocation.x + theme.notebook.menu_button_width,
+			allocation.y,
+			selected_box_width,
+			theme.notebook.tab_height);
+
+	layout.tabs_area.x = allocation.x + theme.notebook.menu_button_width
+			+ selected_box_width;
+	layout.tabs_area.y = allocation.y;
+	layout.tabs_area.w = (int)allocation.w - buttons_width - selected_box_width;
+	layout.tabs_area.h = theme.notebook.tab_height;
+
+	layout.left_scroll_arrow = rect{};
+	layout.right_scroll_arrow = rect{};
+	layout.has_scroll_arrow = layout.tabs_area.w
+			< tab_count * (int)theme.notebook.iconic_tab_width;
+
+	if(layout.has_scroll_arrow) {
+		layout.left_scroll_arrow.x = layout.tabs_area.x;
+		layout.left_scroll_arrow.y = allocation.y;
+		layout.left_scroll_arrow.w = theme.notebook.left_scroll_arrow_width;
+		layout.left_scroll_arrow.h = theme.notebook.tab_height;
+
+		layout.right_scroll_arrow.x = layout.tabs_area.x + layout.tabs_area.w
+				- theme.notebook.right_scroll_arrow_width;
+		layout.right_scroll_arrow.y = allocation.y;
+		layout.right_scroll_arrow.w = theme.notebook.left_scroll_arrow_width;
+		layout.right_scroll_arrow.h = theme.notebook.tab_height;
+
+		layout.tabs_area.w -= (theme.notebook.left_scroll_arrow_width
+				+ theme.notebook.right_scroll_arrow_width);
+		layout.tabs_area.x += theme.notebook.left_scroll_arrow_width;
+	}
+}
+
+auto notebook_iconic_tab_position(theme_t const & theme, int index) -> rect
+{
+	return rect(index * theme.notebook.iconic_tab_width, 0,
+			theme.notebook.iconic_tab_width, theme.notebook.tab_height);
+}
+
+void notebook_selected_tab_buttons(theme_t const & theme,
+		rect const & selected_tab, rect & close, rect & unbind)
+{
+	close.x = selected_tab.x + selected_tab.w
+			- theme.notebook.selected_close_width;
+	close.y = selected_tab.y;
+	close.w = theme.notebook.selected_close_width;
+	close.h = theme.notebook.tab_height;
+
+	unbind.x = selected_tab.x + selected_tab.w
+			- theme.notebook.selected_close_width
+			- theme.notebook.selected_unbind_width;
+	unbind.y = selected_tab.y;
+	unbind.w = theme.notebook.selected_unbind_width;
+	unbind.h = theme.notebook.tab_height;
+}
+
+void notebook_drop_areas(theme_t const & theme, rect const & area,
+		bool can_hsplit, bool can_vsplit, notebook_drop_areas_t & areas)
+{
+	int tab_height = theme.notebook.tab_height;
+
+	areas.tab.x = area.x;
+	areas.tab.y = area.y;
+	areas.tab.w = area.w;
+	areas.tab.h = tab_height;
+
+	if(can_hsplit) {
+		areas.top.x = area.x;
+		areas.top.y = area.y + tab_height;
+		areas.top.w = area.w;
+		areas.top.h = (area.h - tab_height) * 0.2;
+
+		areas.bottom.x = area.x;
+		areas.bottom.y = area.y + (0.8 * (area.h - tab_height));
+		areas.bottom.w = area.w;
+		areas.bottom.h = (area.h - tab_height) * 0.2;
+	} else {
+		areas.top = rect{};
+		areas.bottom = rect{};
+	}
+
+	if(can_vsplit) {
+		areas.left.x = area.x;
+		areas.left.y = area.y + tab_height;
+		areas.left.w = area.w * 0.2;
+		areas.left.h = (area.h - tab_height);
+
+		areas.right.x = area.x + area.w * 0.8;
+		areas.right.y = area.y + tab_height;
+		areas.right.w = area.w * 0.2;
+		areas.right.h = (area.h - tab_height);
+	} else {
+		areas.left = rect{};
+		areas.right = rect{};
+	}
+
+	areas.popup_top.x = area.x;
+	areas.popup_top.y = area.y + tab_height;
+	areas.popup_top.w = area.w;
+	areas.popup_top.h = (area.h - tab_height) * 0.5;
+
+	areas.popup_bottom.x = area.x;
+	areas.popup_bottom.y = area.y + tab_height + (0.5 * (area.h - tab_height));
+	areas.popup_bottom.w = area.w;
+	areas.popup_bottom.h = (area.h - tab_height) * 0.5;
+
+	areas.popup_left.x = area.x;
+	areas.popup_left.y = area.y + tab_height;
+	areas.popup_left.w = area.w * 0.5;
+	areas.popup_left.h = (area.h - tab_height);
+
+	areas.popup_right.x = area.x + area.w * 0.5;
+	areas.popup_right.y = area.y + tab_height;
+	areas.popup_right.w = area.w * 0.5;
+	areas.popup_right.h = (area.h - tab_height);
+
+	areas.popup_center.x = area.x + area.w * 0.2;
+	areas.popup_center.y = area.y + tab_height + (area.h - tab_height) * 0.2;
+	areas.popup_center.w = area.w * 0.6;
+	areas.popup_center.h = (area.h - tab_height) * 0.6;
+}
+
+auto notebook_drop_zone(notebook_drop_areas_t const & areas, int x, int y)
+		-> notebook_area_e
+{
+	if (areas.tab.is_inside(x, y)) {
+		return NOTEBOOK_AREA_TAB;
+	} else if (areas.right.is_inside(x, y)) {
+		return NOTEBOOK_AREA_RIGHT;
+	} else if (areas.top.is_inside(x, y)) {
+		return NOTEBOOK_AREA_TOP;
+	} else if (areas.bottom.is_inside(x, y)) {
+		return NOTEBOOK_AREA_BOTTOM;
+	} else if (areas.left.is_inside(x, y)) {
+		return NOTEBOOK_AREA_LEFT;
+	} else if (areas.popup_center.is_inside(x, y)) {
+		return NOTEBOOK_AREA_CENTER;
+	}
+	return NOTEBOOK_AREA_NONE;
+}
+
+void rect_index_t::update(vector<rect> const & areas)
+{
+	nodes.clear();
+	items.clear();
+
+	for (auto const & area: areas)
+		items.push_back(item_t{area, static_cast<int>(items.size())});
+
+	if (not items.empty())
+		_build(0, items.size());
+}
+
+auto rect_index_t::lookup(int x, int y) const -> int
+{
+	if (nodes.empty())
+		return -1;
+
+	auto node = &nodes[0];
+	while (node->axis >= 0) {
+		int v = node->axis == 0 ? x : y;
+		node = &nodes[v < node->cut ? node->child0 : node->child1];
+	}
+
+	for (int i = node->first; i < node->last; ++i) {
+		if (items[i].area.is_inside(x, y))
+			return items[i].id;
+	}
+
+	return -1;
+}
+
+auto rect_index_t::_build(int first, int last) -> int
+{
+	int index = nodes.size();
+	nodes.push_back(node_t{-1, 0, -1, -1, first, last});
+
+	int axis, cut, middle;
+	if (last - first > 1 and _find_cut(first, last, axis, cut, middle)) {
+		int child0 = _build(first, middle);
+		int child1 = _build(middle, last);
+		/* nodes may have been reallocated */
+		auto & node = nodes[index];
+		node.axis = axis;
+		node.cut = cut;
+		node.child0 = child0;
+		node.child1 = child1;
+	} else {
+		/* overlapping areas, keep the stack order */
+		std::sort(items.begin() + first, items.begin() + last,
+				[](item_t const & a, item_t const & b) { return a.id < b.id; });
+	}
+
+	return index;
+}
+
+/**
+ * Find the cut along x or y that split items in the most balanced way,
+ * such as items before middle end before cut and others start after it.
+ **/
+bool rect_index_t::_find_cut(int first, int last, int & axis, int & cut, int & middle)
+{
+	auto lo = [](item_t const & i, int a) { return a == 0 ? i.area.x : i.area.y; };
+	auto hi = [](item_t const & i, int a) { return a == 0 ? i.area.x + i.area.w : i.area.y + i.area.h; };
+
+	int best_score = -1;
+	for (int a = 0; a < 2; ++a) {
+		std::sort(items.begin() + first, items.begin() + last,
+				[a, &lo](item_t const & x, item_t const & y) { return lo(x, a) < lo(y, a); });
+		int max_hi = hi(items[first], a);
+		for (int i = first + 1; i < last; ++i) {
+			if (max_hi <= lo(items[i], a)) {
+				int score = std::min(i - first, last - i);
+				if (score > best_score) {
+					best_score = score;
+					axis = a;
+					cut = lo(items[i], a);
+					middle = i;
+				}
+			}
+			max_hi = std::max(max_hi, hi(items[i], a));
+		}
+	}
+
+	if (best_score < 0)
+		return false;
+
+	int a = axis;
+	int c = cut;
+	auto split = std::partition(items.begin() + first, items.begin() + last,
+			[a, c, &lo](item_t const & x) { return lo(x, a) < c; });
+	middle = split - items.begin();
+
+	/* only empty items can leave one side empty */
+	if (middle == first or middle == last)
+		return false;
+
+	return true;
+}
+
+auto viewports_allocation(vector<rect> const & work_areas) -> vector<rect>
+{
+	vector<rect> ret;
+	region already_allocated;
+	for (auto const & area: work_areas) {
+		region region_to_alocate{area};
+		region_to_alocate -= already_allocated;
+		for (auto & r: region_to_alocate.rects()) {
+			ret.push_back(r);
+		}
+		already_allocated += region_to_alocate;
+	}
+	return ret;
+}
+
+}
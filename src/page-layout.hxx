@@ -0,0 +1,162 @@
+/*
+ * page-layout.hxx
+ *
+ * copyright (2010-2014) Benoit Gschwind
+ *
+ * This code is licensed under the GPLv3. see COPYING file for more details.
+ *
+ * Geometry of the tiling tree: split and notebook layout, drop zones and
+ * the notebook hit-test index. Only the theme metrics are involved, thus
+ * split_t, notebook_t and workspace_t share this code with
+ * page-benchmark.
+ *
+ */
+
+#ifndef PAGE_LAYOUT_HXX_
+#define PAGE_LAYOUT_HXX_
+
+#include <vector>
+
+#include "page-box.hxx"
+#include "page-theme.hxx"
+
+namespace page {
+
+using namespace std;
+
+enum notebook_area_e {
+	NOTEBOOK_AREA_NONE,
+	NOTEBOOK_AREA_TAB,
+	NOTEBOOK_AREA_TOP,
+	NOTEBOOK_AREA_BOTTOM,
+	NOTEBOOK_AREA_LEFT,
+	NOTEBOOK_AREA_RIGHT,
+	NOTEBOOK_AREA_CENTER
+};
+
+/**
+ * Minimal size of a split given the minimal size of its children.
+ **/
+void split_min_allocation(theme_t const & theme, split_type_e type,
+		int width0, int height0, int width1, int height1,
+		int & width, int & height);
+
+/**
+ * Share allocation between children at the given ratio, children never get
+ * less than their minimal size.
+ **/
+void split_children_allocation(theme_t const & theme, split_type_e type,
+		rect const & allocation, double split,
+		int width0, int height0, int width1, int height1,
+		rect & bpack0, rect & bpack1);
+
+auto split_bar_location(theme_t const & theme, split_type_e type,
+		rect const & allocation, rect const & bpack0) -> rect;
+
+void notebook_min_allocation(theme_t const & theme, int & width, int & height);
+
+/**
+ * Area left to the selected client and whether the notebook is large
+ * enough to be split.
+ **/
+void notebook_client_area(theme_t const & theme, rect const & allocation,
+		rect & client_area, bool & can_hsplit, bool & can_vsplit);
+
+/**
+ * Buttons of the tab bar, close, hsplit, vsplit and bookmark are packed at
+ * the right and the menu at the left.
+ **/
+void notebook_buttons_area(theme_t const & theme, rect const & allocation,
+		rect & close, rect & hsplit, rect & vsplit, rect & bookmark,
+		rect & menu);
+
+struct notebook_tabs_layout_t {
+	rect selected_tab;
+	/** visible part of iconic tabs, scroll arrows excluded **/
+	rect tabs_area;
+	bool has_scroll_arrow;
+	rect left_scroll_arrow;
+	rect right_scroll_arrow;
+};
+
+/**
+ * Layout the tab bar of a notebook with tab_count > 0 clients, the
+ * selected tab is stretched and other tabs are iconic.
+ **/
+void notebook_tabs_layout(theme_t const & theme, rect const & allocation,
+		int tab_count, notebook_tabs_layout_t & layout);
+
+/** position of an iconic tab, relative to the tabs area before scrolling **/
+auto notebook_iconic_tab_position(theme_t const & theme, int index) -> rect;
+
+void notebook_selected_tab_buttons(theme_t const & theme,
+		rect const & selected_tab, rect & close, rect & unbind);
+
+struct notebook_drop_areas_t {
+	rect tab;
+	rect top;
+	rect bottom;
+	rect left;
+	rect right;
+
+	rect popup_top;
+	rect popup_bottom;
+	rect popup_left;
+	rect popup_right;
+	rect popup_center;
+};
+
+/**
+ * Areas used to drop a view on a notebook, area is the root area of the
+ * notebook.
+ **/
+void notebook_drop_areas(theme_t const & theme, rect const & area,
+		bool can_hsplit, bool can_vsplit, notebook_drop_areas_t & areas);
+
+auto notebook_drop_zone(notebook_drop_areas_t const & areas, int x, int y)
+		-> notebook_area_e;
+
+/**
+ * Flattened BSP over rectangles, used to find the notebook under the
+ * pointer while dragging. Notebooks of a viewport tile it, thus a cut that
+ * separate them always exist, except for overlapping viewports, then the
+ * leaf keep all of them in stack order.
+ **/
+struct rect_index_t {
+	struct node_t {
+		int axis; // -1 for leaf, 0 for x, 1 for y
+		int cut;
+		int child0;
+		int child1;
+		int first;
+		int last;
+	};
+
+	struct item_t {
+		rect area;
+		int id; // index in the updated list, also the stack order
+	};
+
+	vector<node_t> nodes;
+	vector<item_t> items;
+
+	void update(vector<rect> const & areas);
+
+	/** the id of the first area that contains (x, y) or -1 **/
+	auto lookup(int x, int y) const -> int;
+
+private:
+	auto _build(int first, int last) -> int;
+	bool _find_cut(int first, int last, int & axis, int & cut, int & middle);
+
+};
+
+/**
+ * Split monitor work areas into non-overlapping viewport areas, the
+ * earlier monitors keep the overlapped parts.
+ **/
+auto viewports_allocation(vector<rect> const & work_areas) -> vector<rect>;
+
+}
+
+#endif /* PAGE_LAYOUT_HXX_ */
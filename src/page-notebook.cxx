@@ -29,8 +29,10 @@ notebook_t::notebook_t(tree_t * ref) :
 	_can_hsplit{true},
 	_can_vsplit{true},
 	_theme_client_tabs_offset{0},
+	_theme_client_tabs_cache{nullptr},
+	_theme_client_tabs_cache_is_valid{false},
+	_drop_areas_is_valid{false},
 	_has_scroll_arrow{false},
-	animation_duration{ref->_root->_ctx->conf()._fade_in_time},
 	_has_pending_fading_timeout{false}
 {
 	//printf("call %s (%p)\n", __PRETTY_FUNCTION__, this);
@@ -54,6 +56,8 @@ notebook_t::notebook_t(tree_t * ref) :
 notebook_t::~notebook_t() {
 	//printf("call %s (%p)\n", __PRETTY_FUNCTION__, this);
 	_clients_tab_order.clear();
+	if(_theme_client_tabs_cache != nullptr)
+		cairo_surface_destroy(_theme_client_tabs_cache);
 }
 
 bool notebook_t::add_client(client_managed_p c, xcb_timestamp_t time) {
@@ -202,106 +206,21 @@ void notebook_t::set_allocation(rect const & area) {
 	assert(area.w >= width);
 	assert(area.h >= height);
 
+	/* the previous area may be uncovered */
+	queue_redraw_area(_allocation);
 	_allocation = area;
 	_update_all_layout();
 	queue_redraw();
 }
 
 void notebook_t::_update_all_layout() {
+	notebook_client_area(*_ctx->theme(), _allocation, _client_area,
+			_can_hsplit, _can_vsplit);
 
-	int min_width;
-	int min_height;
-	get_min_allocation(min_width, min_height);
-
-	if (_allocation.w < min_width * 2 + _ctx->theme()->split.margin.left
-			+ _ctx->theme()->split.margin.right  + _ctx->theme()->split.width) {
-		_can_vsplit = false;
-	} else {
-		_can_vsplit = true;
-	}
-
-	if (_allocation.h < min_height * 2 + _ctx->theme()->split.margin.top
-			+ _ctx->theme()->split.margin.bottom  + _ctx->theme()->split.width) {
-		_can_hsplit = false;
-	} else {
-		_can_hsplit = true;
-	}
-
-	_client_area.x = _allocation.x + _ctx->theme()->notebook.margin.left;
-	_client_area.y = _allocation.y + _ctx->theme()->notebook.margin.top + _ctx->theme()->notebook.tab_height;
-	_client_area.w = _allocation.w - _ctx->theme()->notebook.margin.left - _ctx->theme()->notebook.margin.right;
-	_client_area.h = _allocation.h - _ctx->theme()->notebook.margin.top - _ctx->theme()->notebook.margin.bottom - _ctx->theme()->notebook.tab_height;
-
-	auto window_position = get_window_position();
-
-	_area.tab.x = _allocation.x + window_position.x;
-	_area.tab.y = _allocation.y + window_position.y;
-	_area.tab.w = _allocation.w;
-	_area.tab.h = _ctx->theme()->notebook.tab_height;
-
-	if(_can_hsplit) {
-		_area.top.x = _allocation.x + window_position.x;
-		_area.top.y = _allocation.y + window_position.y + _ctx->theme()->notebook.tab_height;
-		_area.top.w = _allocation.w;
-		_area.top.h = (_allocation.h - _ctx->theme()->notebook.tab_height) * 0.2;
-
-		_area.bottom.x = _allocation.x + window_position.x;
-		_area.bottom.y = _allocation.y + window_position.y + (0.8 * (allocation().h - _ctx->theme()->notebook.tab_height));
-		_area.bottom.w = _allocation.w;
-		_area.bottom.h = (_allocation.h - _ctx->theme()->notebook.tab_height) * 0.2;
-	} else {
-		_area.top = rect{};
-		_area.bottom = rect{};
-	}
-
-	if(_can_vsplit) {
-		_area.left.x = _allocation.x + window_position.x;
-		_area.left.y = _allocation.y + window_position.y + _ctx->theme()->notebook.tab_height;
-		_area.left.w = _allocation.w * 0.2;
-		_area.left.h = (_allocation.h - _ctx->theme()->notebook.tab_height);
-
-		_area.right.x = _allocation.x + window_position.x + _allocation.w * 0.8;
-		_area.right.y = _allocation.y + window_position.y + _ctx->theme()->notebook.tab_height;
-		_area.right.w = _allocation.w * 0.2;
-		_area.right.h = (_allocation.h - _ctx->theme()->notebook.tab_height);
-	} else {
-		_area.left = rect{};
-		_area.right = rect{};
-	}
-
-	_area.popup_top.x = _allocation.x + window_position.x;
-	_area.popup_top.y = _allocation.y + window_position.y + _ctx->theme()->notebook.tab_height;
-	_area.popup_top.w = _allocation.w;
-	_area.popup_top.h = (_allocation.h - _ctx->theme()->notebook.tab_height) * 0.5;
-
-	_area.popup_bottom.x = _allocation.x + window_position.x;
-	_area.popup_bottom.y = _allocation.y + window_position.y + _ctx->theme()->notebook.tab_height
-			+ (0.5 * (_allocation.h - _ctx->theme()->notebook.tab_height));
-	_area.popup_bottom.w = _allocation.w;
-	_area.popup_bottom.h = (_allocation.h - _ctx->theme()->notebook.tab_height) * 0.5;
-
-	_area.popup_left.x = _allocation.x + window_position.x;
-	_area.popup_left.y = _allocation.y + window_position.y + _ctx->theme()->notebook.tab_height;
-	_area.popup_left.w = _allocation.w * 0.5;
-	_area.popup_left.h = (_allocation.h - _ctx->theme()->notebook.tab_height);
-
-	_area.popup_right.x = _allocation.x + window_position.x + allocation().w * 0.5;
-	_area.popup_right.y = _allocation.y + window_position.y + _ctx->theme()->notebook.tab_height;
-	_area.popup_right.w = _allocation.w * 0.5;
-	_area.popup_right.h = (_allocation.h - _ctx->theme()->notebook.tab_height);
-
-	_area.popup_center.x = _allocation.x + window_position.x + allocation().w * 0.2;
-	_area.popup_center.y = _allocation.y + window_position.y + _ctx->theme()->notebook.tab_height + (allocation().h - _ctx->theme()->notebook.tab_height) * 0.2;
-	_area.popup_center.w = _allocation.w * 0.6;
-	_area.popup_center.h = (_allocation.h - _ctx->theme()->notebook.tab_height) * 0.6;
-
-	if(_client_area.w <= 0) {
-		_client_area.w = 1;
-	}
-
-	if(_client_area.h <= 0) {
-		_client_area.h = 1;
-	}
+	/* drop areas are computed on demand */
+	_drop_areas_is_valid = false;
+	if (_root != nullptr)
+		_root->invalidate_notebook_index();
 
 	if (_selected) {
 		update_client_position(_selected);
@@ -316,6 +235,23 @@ void notebook_t::_update_all_layout() {
 	queue_redraw();
 }
 
+/**
+ * Compute areas used to drop a view on this notebook, they are only used
+ * while dragging a view, thus they are updated on demand.
+ **/
+void notebook_t::_update_drop_areas() {
+	if (_drop_areas_is_valid)
+		return;
+
+	auto window_position = get_window_position();
+	rect area = _allocation;
+	area.x += window_position.x;
+	area.y += window_position.y;
+	notebook_drop_areas(*_ctx->theme(), area, _can_hsplit, _can_vsplit, _area);
+
+	_drop_areas_is_valid = true;
+}
+
 rect notebook_t::_compute_client_size(shared_ptr<client_managed_t> c) {
 	dimention_t<unsigned> size(_client_area.w, _client_area.h);
 			//c->compute_size_with_constrain(_client_area.w, _client_area.h);
@@ -367,114 +303,71 @@ void notebook_t::render_legacy(cairo_t * cr) {
 	_ctx->theme()->render_notebook(cr, &_theme_notebook);
 
 	if(_theme_client_tabs.size() > 0) {
-		cairo_surface_t * pix = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
-				_theme_client_tabs.back().position.x + 100,
-				_ctx->theme()->notebook.tab_height);
-		cairo_t * xcr = cairo_create(pix);
-
-		cairo_set_operator(xcr, CAIRO_OPERATOR_SOURCE);
-		cairo_set_source_rgba(xcr, 0.0, 0.0, 0.0, 0.0);
-		cairo_paint(xcr);
-
-		_ctx->theme()->render_iconic_notebook(xcr, _theme_client_tabs);
-		cairo_destroy(xcr);
+		_update_theme_client_tabs_cache();
 
 		cairo_save(cr);
-		cairo_set_source_surface(cr, pix,
+		cairo_set_source_surface(cr, _theme_client_tabs_cache,
 				_theme_client_tabs_area.x - _theme_client_tabs_offset,
 				_theme_client_tabs_area.y);
 		cairo_clip(cr, _theme_client_tabs_area);
 		cairo_paint(cr);
 
 		cairo_restore(cr);
-		cairo_surface_destroy(pix);
 	}
 
 }
 
-rect notebook_t::_compute_notebook_bookmark_position() const {
-	return rect(
-		_allocation.x + _allocation.w
-		- _ctx->theme()->notebook.close_width
-		- _ctx->theme()->notebook.hsplit_width
-		- _ctx->theme()->notebook.vsplit_width
-		- _ctx->theme()->notebook.mark_width,
-		_allocation.y,
-		_ctx->theme()->notebook.mark_width,
-		_ctx->theme()->notebook.tab_height
-	);
-}
+/**
+ * Render iconic tabs only if they changed since the last call, the
+ * surface is reused while its size match.
+ **/
+void notebook_t::_update_theme_client_tabs_cache() {
+	int width = _theme_client_tabs.back().position.x + 100;
+	int height = _ctx->theme()->notebook.tab_height;
 
-rect notebook_t::_compute_notebook_vsplit_position() const {
-	return rect(
-		_allocation.x + _allocation.w
-			- _ctx->theme()->notebook.close_width
-			- _ctx->theme()->notebook.hsplit_width
-			- _ctx->theme()->notebook.vsplit_width,
-		_allocation.y,
-		_ctx->theme()->notebook.vsplit_width,
-		_ctx->theme()->notebook.tab_height
-	);
-}
+	if(_theme_client_tabs_cache != nullptr
+			and (cairo_image_surface_get_width(_theme_client_tabs_cache) != width
+			or cairo_image_surface_get_height(_theme_client_tabs_cache) != height)) {
+		cairo_surface_destroy(_theme_client_tabs_cache);
+		_theme_client_tabs_cache = nullptr;
+	}
 
-rect notebook_t::_compute_notebook_hsplit_position() const {
+	if(_theme_client_tabs_cache == nullptr) {
+		_theme_client_tabs_cache = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+				width, height);
+		_theme_client_tabs_cache_is_valid = false;
+	}
 
-	return rect(
-		_allocation.x + _allocation.w - _ctx->theme()->notebook.close_width - _ctx->theme()->notebook.hsplit_width,
-		_allocation.y,
-		_ctx->theme()->notebook.hsplit_width,
-		_ctx->theme()->notebook.tab_height
-	);
+	if(_theme_client_tabs_cache_is_valid)
+		return;
 
-}
+	cairo_t * xcr = cairo_create(_theme_client_tabs_cache);
 
-rect notebook_t::_compute_notebook_close_position() const {
-	return rect(
-		_allocation.x + _allocation.w - _ctx->theme()->notebook.close_width,
-		_allocation.y,
-		_ctx->theme()->notebook.close_width,
-		_ctx->theme()->notebook.tab_height
-	);
-}
+	cairo_set_operator(xcr, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_rgba(xcr, 0.0, 0.0, 0.0, 0.0);
+	cairo_paint(xcr);
+	cairo_set_operator(xcr, CAIRO_OPERATOR_OVER);
 
-rect notebook_t::_compute_notebook_menu_position() const {
-	return rect(
-		_allocation.x,
-		_allocation.y,
-		_ctx->theme()->notebook.menu_button_width,
-		_ctx->theme()->notebook.tab_height
-	);
+	_ctx->theme()->render_iconic_notebook(xcr, _theme_client_tabs);
+	cairo_destroy(xcr);
 
+	_theme_client_tabs_cache_is_valid = true;
 }
 
 void notebook_t::_update_notebook_buttons_area() {
 
 	_client_buttons.clear();
 
-	_area.button_close = _compute_notebook_close_position();
-	_area.button_hsplit = _compute_notebook_hsplit_position();
-	_area.button_vsplit = _compute_notebook_vsplit_position();
-	_area.button_select = _compute_notebook_bookmark_position();
-	_area.button_exposay = _compute_notebook_menu_position();
+	notebook_buttons_area(*_ctx->theme(), _allocation, _area.button_close,
+			_area.button_hsplit, _area.button_vsplit, _area.button_select,
+			_area.button_exposay);
 
 	if(_clients_tab_order.size() > 0) {
 
 		if(_selected != nullptr) {
 			rect & b = _theme_notebook.selected_client.position;
-
-			_area.close_client.x = b.x + b.w
-					- _ctx->theme()->notebook.selected_close_width;
-			_area.close_client.y = b.y;
-			_area.close_client.w =
-					_ctx->theme()->notebook.selected_close_width;
-			_area.close_client.h = _ctx->theme()->notebook.tab_height;
-
-			_area.undck_client.x = b.x + b.w
-					- _ctx->theme()->notebook.selected_close_width
-					- _ctx->theme()->notebook.selected_unbind_width;
-			_area.undck_client.y = b.y;
-			_area.undck_client.w = _ctx->theme()->notebook.selected_unbind_width;
-			_area.undck_client.h = _ctx->theme()->notebook.tab_height;
+			notebook_selected_tab_buttons(*_ctx->theme(), b,
+					_area.close_client, _area.undck_client);
 
 			_client_buttons.push_back(std::make_tuple(b, view_notebook_w{_selected}, &_theme_notebook.selected_client));
 
@@ -514,42 +407,21 @@ void notebook_t::_update_theme_notebook(theme_notebook_t & theme_notebook) {
 	theme_notebook.can_vsplit = _can_vsplit;
 	theme_notebook.client_count = _clients_tab_order.size();
 
+	/* keep previous tabs to check if the cached rendering is still valid */
+	auto previous_tabs = std::move(_theme_client_tabs);
 	_theme_client_tabs.clear();
 
 	if (_clients_tab_order.size() != 0) {
-		int selected_box_width = ((int)_allocation.w
-				- (int)_ctx->theme()->notebook.close_width
-				- (int)_ctx->theme()->notebook.hsplit_width
-				- (int)_ctx->theme()->notebook.vsplit_width
-				- (int)_ctx->theme()->notebook.mark_width
-				- (int)_ctx->theme()->notebook.menu_button_width)
-				- (int)_clients_tab_order.size() * (int)_ctx->theme()->notebook.iconic_tab_width;
-
-		if(selected_box_width < 200) {
-			selected_box_width = 200;
-		}
+		notebook_tabs_layout_t layout;
+		notebook_tabs_layout(*_ctx->theme(), _allocation,
+				_clients_tab_order.size(), layout);
 
-		_theme_client_tabs_area.x = _allocation.x
-				+ _ctx->theme()->notebook.menu_button_width
-				+ selected_box_width;
-		_theme_client_tabs_area.y = _allocation.y;
-		_theme_client_tabs_area.w = ((int)_allocation.w
-				- (int)_ctx->theme()->notebook.close_width
-				- (int)_ctx->theme()->notebook.hsplit_width
-				- (int)_ctx->theme()->notebook.vsplit_width
-				- (int)_ctx->theme()->notebook.mark_width
-				- (int)_ctx->theme()->notebook.menu_button_width
-				- (int)selected_box_width);
-		_theme_client_tabs_area.h = _ctx->theme()->notebook.tab_height;
+		_theme_client_tabs_area = layout.tabs_area;
 
 		if (_selected != nullptr) {
 			/** copy the tab context **/
 			theme_notebook.selected_client = theme_tab_t{};
-			theme_notebook.selected_client.position = rect(
-					_allocation.x + _ctx->theme()->notebook.menu_button_width,
-					_allocation.y,
-					selected_box_width,
-					_ctx->theme()->notebook.tab_height);
+			theme_notebook.selected_client.position = layout.selected_tab;
 
 			if(_selected->has_focus()) {
 				theme_notebook.selected_client.tab_color =
@@ -567,15 +439,11 @@ void notebook_t::_update_theme_notebook(theme_notebook_t & theme_notebook) {
 			theme_notebook.has_selected_client = false;
 		}
 
-		int offset = 0;
 		for (auto const & i : _clients_tab_order) {
 			_theme_client_tabs.push_back(theme_tab_t { });
 			auto & tab = _theme_client_tabs.back();
-			tab.position = rect(
-				offset,
-				0,
-				_ctx->theme()->notebook.iconic_tab_width,
-				_ctx->theme()->notebook.tab_height);
+			tab.position = notebook_iconic_tab_position(*_ctx->theme(),
+					_theme_client_tabs.size() - 1);
 
 			if (i->has_focus()) {
 				tab.tab_color = _ctx->theme()->get_focused_color();
@@ -587,39 +455,17 @@ void notebook_t::_update_theme_notebook(theme_notebook_t & theme_notebook) {
 			tab.title = i->title();
 			//tab.icon = i->icon();
 			tab.is_iconic = i->is_iconic();
-			offset += _ctx->theme()->notebook.iconic_tab_width;
 		}
 
-		_area.left_scroll_arrow = rect{};
-		_area.right_scroll_arrow = rect{};
-		if(_theme_client_tabs_area.w < _theme_client_tabs.back().position.x + _theme_client_tabs.back().position.w) {
-			_has_scroll_arrow = true;
-			theme_notebook.has_scroll_arrow = true;
-
-			_area.left_scroll_arrow.x = _theme_client_tabs_area.x;
-			_area.left_scroll_arrow.y = _allocation.y;
-			_area.left_scroll_arrow.w = _ctx->theme()->notebook.left_scroll_arrow_width;
-			_area.left_scroll_arrow.h = _ctx->theme()->notebook.tab_height;
-
-			_area.right_scroll_arrow.x = _theme_client_tabs_area.x + _theme_client_tabs_area.w - _ctx->theme()->notebook.right_scroll_arrow_width;
-			_area.right_scroll_arrow.y = _allocation.y;
-			_area.right_scroll_arrow.w = _ctx->theme()->notebook.left_scroll_arrow_width;
-			_area.right_scroll_arrow.h = _ctx->theme()->notebook.tab_height;
-
-			theme_notebook.left_arrow_position = _area.left_scroll_arrow;
-			theme_notebook.right_arrow_position = _area.right_scroll_arrow;
-
-			_theme_client_tabs_area.w -= (_ctx->theme()->notebook.left_scroll_arrow_width + _ctx->theme()->notebook.right_scroll_arrow_width);
-			_theme_client_tabs_area.x += _ctx->theme()->notebook.left_scroll_arrow_width;
-
-		} else {
-			_area.left_scroll_arrow = rect{};
-			_area.right_scroll_arrow = rect{};
-			_has_scroll_arrow = false;
-			theme_notebook.has_scroll_arrow = false;
+		_area.left_scroll_arrow = layout.left_scroll_arrow;
+		_area.right_scroll_arrow = layout.right_scroll_arrow;
+		_has_scroll_arrow = layout.has_scroll_arrow;
+		theme_notebook.has_scroll_arrow = layout.has_scroll_arrow;
+		if(layout.has_scroll_arrow) {
+			theme_notebook.left_arrow_position = layout.left_scroll_arrow;
+			theme_notebook.right_arrow_position = layout.right_scroll_arrow;
 		}
 
-
 	} else {
 		theme_notebook.has_selected_client = false;
 	}
@@ -630,6 +476,9 @@ void notebook_t::_update_theme_notebook(theme_notebook_t & theme_notebook) {
 	}
 	theme_notebook.is_default = is_default();
 
+	if(previous_tabs != _theme_client_tabs)
+		_theme_client_tabs_cache_is_valid = false;
+
 }
 
 auto notebook_t::button_press(ClutterEvent const * e) -> button_action_e
@@ -881,6 +730,7 @@ bool notebook_t::leave(ClutterEvent const * ev) {
 
 void notebook_t::_mouse_over_reset() {
 	if (_mouse_over.tab != nullptr) {
+		_theme_client_tabs_cache_is_valid = false;
 		if (std::get<1>(*_mouse_over.tab).lock()->has_focus()) {
 			std::get<2>(*_mouse_over.tab)->tab_color =
 					_ctx->theme()->get_focused_color();
@@ -901,6 +751,7 @@ void notebook_t::_mouse_over_reset() {
 
 void notebook_t::_mouse_over_set() {
 	if (_mouse_over.tab != nullptr) {
+		_theme_client_tabs_cache_is_valid = false;
 		std::get<2>(*_mouse_over.tab)->tab_color = _ctx->theme()->get_mouse_over_color();
 	}
 }
@@ -911,6 +762,7 @@ void notebook_t::_client_title_change(client_managed_t * c) {
 			std::get<2>(x)->title = c->title();
 		}
 	}
+	_theme_client_tabs_cache_is_valid = false;
 
 	if(_selected and c == _selected->_client.get()) {
 		_theme_notebook.selected_client.title = c->title();
@@ -979,19 +831,7 @@ auto notebook_t::shared_from_this() -> notebook_p {
 }
 
 void notebook_t::get_min_allocation(int & width, int & height) const {
-	height = _ctx->theme()->notebook.tab_height
-			+ _ctx->theme()->notebook.margin.top
-			+ _ctx->theme()->notebook.margin.bottom + 20;
-	width = _ctx->theme()->notebook.margin.left
-			+ _ctx->theme()->notebook.margin.right + 100
-			+ _ctx->theme()->notebook.close_width
-			+ _ctx->theme()->notebook.selected_close_width
-			+ _ctx->theme()->notebook.selected_unbind_width
-			+ _ctx->theme()->notebook.vsplit_width
-			+ _ctx->theme()->notebook.hsplit_width
-			+ _ctx->theme()->notebook.mark_width
-			+ _ctx->theme()->notebook.menu_button_width
-			+ _ctx->theme()->notebook.iconic_tab_width * 4;
+	notebook_min_allocation(*_ctx->theme(), width, height);
 }
 
 void  notebook_t::_scroll_right(int x) {
@@ -1075,8 +915,20 @@ void notebook_t::_set_theme_tab_offset(int x) {
 	_theme_client_tabs_offset = x;
 }
 
+auto notebook_t::pointer_target(int x, int y) -> tree_t * {
+	if (_allocation.is_inside(x, y))
+		return this;
+	return nullptr;
+}
+
+/** drop everything rendered or computed with the previous theme **/
+void notebook_t::update_theme() {
+	_theme_client_tabs_cache_is_valid = false;
+	_update_all_layout();
+}
+
 void notebook_t::queue_redraw() {
-	tree_t::queue_redraw();
+	queue_redraw_area(_allocation);
 }
 
 }
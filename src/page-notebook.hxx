@@ -16,6 +16,7 @@
 #include <memory>
 
 #include "page-theme.hxx"
+#include "page-layout.hxx"
 
 #include "page-page-component.hxx"
 #include "page-client-managed.hxx"
@@ -30,8 +31,6 @@ class client_managed_t;
 class grab_bind_view_notebook_t;
 
 class notebook_t : public page_component_t {
-	time64_t const animation_duration;
-
 	page_t * _ctx;
 
 	rect _allocation;
@@ -49,6 +48,10 @@ class notebook_t : public page_component_t {
 	vector<theme_tab_t> _theme_client_tabs;
 	rect _theme_client_tabs_area;
 
+	/** rendering of iconic tabs, scrolling only change the blit offset **/
+	cairo_surface_t * _theme_client_tabs_cache;
+	bool _theme_client_tabs_cache_is_valid;
+
 	bool _is_default;
 	bool _exposay;
 
@@ -79,7 +82,8 @@ class notebook_t : public page_component_t {
 	rect _client_area;
 	rect _client_position;
 
-	struct {
+	/* tab, top, bottom, left, right and popup_* are the drop areas */
+	struct : public notebook_drop_areas_t {
 		rect button_close;
 		rect button_vsplit;
 		rect button_hsplit;
@@ -92,20 +96,11 @@ class notebook_t : public page_component_t {
 		rect close_client;
 		rect undck_client;
 
-		rect tab;
-		rect top;
-		rect bottom;
-		rect left;
-		rect right;
-
-		rect popup_top;
-		rect popup_bottom;
-		rect popup_left;
-		rect popup_right;
-		rect popup_center;
-
 	} _area;
 
+	/** tab, top, bottom, left, right and popup_* of _area are up to date **/
+	bool _drop_areas_is_valid;
+
 	/* list of tabs and exposay buttons */
 	vector<tuple<rect, view_notebook_w, theme_tab_t *>> _client_buttons;
 	vector<tuple<rect, view_notebook_w, int>> _exposay_buttons;
@@ -113,18 +108,16 @@ class notebook_t : public page_component_t {
 	void _update_notebook_buttons_area();
 	void _update_theme_notebook(theme_notebook_t & theme_notebook);
 	void _update_all_layout();
+	void _update_drop_areas();
 	void _update_mouse_over(int x, int y);
 
 	void _mouse_over_reset();
 	void _mouse_over_set();
 
+	void _update_theme_client_tabs_cache();
+
 	rect _compute_notebook_close_window_position(int number_of_client, int selected_client_index) const;
 	rect _compute_notebook_unbind_window_position(int number_of_client, int selected_client_index) const;
-	rect _compute_notebook_bookmark_position() const;
-	rect _compute_notebook_vsplit_position() const;
-	rect _compute_notebook_hsplit_position() const;
-	rect _compute_notebook_close_position() const;
-	rect _compute_notebook_menu_position() const;
 
 	void _client_title_change(client_managed_t * c);
 	void _client_destroy(client_managed_t * c);
@@ -182,8 +175,11 @@ public:
 	virtual void on_workspace_enable() override;
 	virtual void on_workspace_disable() override;
 
+	virtual auto pointer_target(int x, int y) -> tree_t * override;
 	virtual void queue_redraw();
 
+	void update_theme();
+
 	/**
 	 * page_component_t interface
 	 **/
@@ -11,6 +11,8 @@
 #include <typeinfo>
 #include <xcb/xcb.h>
 #include <memory>
+#include <string>
+#include <array>
 
 #include <clutter/clutter.h>
 
@@ -77,12 +79,20 @@ struct grab_handler_t {
 	virtual void key_release(ClutterEvent const * ev) = 0;
 };
 
+/**
+ * Typed snapshot of page.conf, parsed once when the configuration is
+ * (re)loaded, see page_t::_compile_configuration.
+ **/
 struct page_configuration_t {
+	string _theme_dir;
+	string _theme_engine;
+	array<string, 10> _exec_cmd;
 	bool _replace_wm;
 	bool _menu_drop_down_shadow;
 	bool _auto_refocus;
 	bool _mouse_focus;
 	bool _enable_shade_windows;
+	bool _render_component_actors;
 	int64_t _fade_in_time;
 };
 
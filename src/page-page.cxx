@@ -88,18 +88,18 @@ void page_t::set_keybinding_custom_helper(char const * name, key_handler_func fu
 
 void page_t::_handler_key_make_notebook_window(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
-	log::printf("window = %p\n", window);
-	log::printf("focus = %p\n", meta_display_get_focus_window(display));
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "window = %p\n", window);
+	log(LOG_KEYBINDING, "focus = %p\n", meta_display_get_focus_window(display));
 	auto focussed = meta_display_get_focus_window(display);
 	auto mw = lookup_client_managed_with(focussed);
 	if (mw == nullptr) {
-		log::printf("managed client not found\n");
+		log(LOG_KEYBINDING, "managed client not found\n");
 		return;
 	}
 	auto v = current_workspace()->lookup_view_for(mw);
 	if (v == nullptr) {
-		log::printf("view not found\n");
+		log(LOG_KEYBINDING, "view not found\n");
 		return;
 	}
 	current_workspace()->switch_view_to_notebook(v, event->time);
@@ -107,21 +107,21 @@ void page_t::_handler_key_make_notebook_window(MetaDisplay * display, MetaScreen
 
 void page_t::_handler_key_make_fullscreen_window(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_key_make_floating_window(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 	auto focussed = meta_display_get_focus_window(display);
 	auto mw = lookup_client_managed_with(focussed);
 	if (mw == nullptr) {
-		log::printf("managed client not found\n");
+		log(LOG_KEYBINDING, "managed client not found\n");
 		return;
 	}
 	auto v = current_workspace()->lookup_view_for(mw);
 	if (v == nullptr) {
-		log::printf("view not found\n");
+		log(LOG_KEYBINDING, "view not found\n");
 		return;
 	}
 	current_workspace()->switch_view_to_floating(v, event->time);
@@ -129,63 +129,63 @@ void page_t::_handler_key_make_floating_window(MetaDisplay * display, MetaScreen
 
 void page_t::_handler_key_page_quit(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 	meta_quit(META_EXIT_SUCCESS);
 }
 
 void page_t::_handler_key_toggle_fullscreen(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_key_debug_1(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_key_debug_2(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_key_debug_3(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_key_debug_4(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_key_run_cmd_0(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
-	run_cmd(bind_cmd[0].cmd);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
+	run_cmd(configuration._exec_cmd[0]);
 }
 
 void page_t::_handler_key_run_cmd_1(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
-	run_cmd(bind_cmd[1].cmd);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
+	run_cmd(configuration._exec_cmd[1]);
 }
 
 void page_t::_handler_key_run_cmd_2(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
-	run_cmd(bind_cmd[2].cmd);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
+	run_cmd(configuration._exec_cmd[2]);
 }
 
 void page_t::_handler_key_run_cmd_3(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
-	run_cmd(bind_cmd[3].cmd);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
+	run_cmd(configuration._exec_cmd[3]);
 }
 
 void page_t::_handler_key_run_cmd_4(MetaDisplay * display, MetaScreen * screen, MetaWindow * window, ClutterKeyEvent * event, MetaKeyBinding * binding)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
-	run_cmd(bind_cmd[4].cmd);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
+	run_cmd(configuration._exec_cmd[4]);
 }
 
 page_t::page_t(MetaPlugin * plugin) :
@@ -200,19 +200,20 @@ page_t::page_t(MetaPlugin * plugin) :
 	_current_workspace = nullptr;
 	_grab_handler = nullptr;
 	_schedule_repaint = false;
+	_move_resize_repaint_func_id = 0;
 
 	identity_window = XCB_NONE;
+	_conf_reload_timeout_id = 0;
 
-	char const * conf_file_name = 0;
-
-	configuration._replace_wm = false;
+	/* PAGE_LOG=focus,grab enable debug logs of those modules */
+	log::set_modules(getenv("PAGE_LOG"));
 
-	configuration._menu_drop_down_shadow = false;
+	char const * conf_file_name = 0;
 
 	/* load configurations, from lower priority to high one */
 
 	/* load default configuration */
-	_conf.merge_from_file_if_exist(string{GNOME_SHELL_DATADIR "/page.conf"});
+	_conf_files.push_back(string{GNOME_SHELL_DATADIR "/page.conf"});
 
 	/* load homedir configuration */
 	{
@@ -220,18 +221,17 @@ page_t::page_t(MetaPlugin * plugin) :
 		if(chome != nullptr) {
 			string xhome = chome;
 			string file = xhome + "/.page.conf";
-			_conf.merge_from_file_if_exist(file);
+			_conf_files.push_back(file);
 		}
 	}
 
 	/* load file in arguments if provided */
 	if (conf_file_name != nullptr) {
-		string s(conf_file_name);
-		_conf.merge_from_file_if_exist(s);
+		_conf_files.push_back(string{conf_file_name});
 	}
 
-	page_base_dir = _conf.get_string("default", "theme_dir");
-	_theme_engine = _conf.get_string("default", "theme_engine");
+	for (auto const & f: _conf_files)
+		_conf.merge_from_file_if_exist(f);
 
 	_last_focus_time = XCB_TIME_CURRENT_TIME;
 	_last_button_press = XCB_TIME_CURRENT_TIME;
@@ -257,59 +257,155 @@ page_t::page_t(MetaPlugin * plugin) :
 	bind_debug_3 = _conf.get_string("default", "bind_debug_3");
 	bind_debug_4 = _conf.get_string("default", "bind_debug_4");
 
-	bind_cmd[0].key = _conf.get_string("default", "bind_cmd_0");
-	bind_cmd[1].key = _conf.get_string("default", "bind_cmd_1");
-	bind_cmd[2].key = _conf.get_string("default", "bind_cmd_2");
-	bind_cmd[3].key = _conf.get_string("default", "bind_cmd_3");
-	bind_cmd[4].key = _conf.get_string("default", "bind_cmd_4");
-	bind_cmd[5].key = _conf.get_string("default", "bind_cmd_5");
-	bind_cmd[6].key = _conf.get_string("default", "bind_cmd_6");
-	bind_cmd[7].key = _conf.get_string("default", "bind_cmd_7");
-	bind_cmd[8].key = _conf.get_string("default", "bind_cmd_8");
-	bind_cmd[9].key = _conf.get_string("default", "bind_cmd_9");
-
-	bind_cmd[0].cmd = _conf.get_string("default", "exec_cmd_0");
-	bind_cmd[1].cmd = _conf.get_string("default", "exec_cmd_1");
-	bind_cmd[2].cmd = _conf.get_string("default", "exec_cmd_2");
-	bind_cmd[3].cmd = _conf.get_string("default", "exec_cmd_3");
-	bind_cmd[4].cmd = _conf.get_string("default", "exec_cmd_4");
-	bind_cmd[5].cmd = _conf.get_string("default", "exec_cmd_5");
-	bind_cmd[6].cmd = _conf.get_string("default", "exec_cmd_6");
-	bind_cmd[7].cmd = _conf.get_string("default", "exec_cmd_7");
-	bind_cmd[8].cmd = _conf.get_string("default", "exec_cmd_8");
-	bind_cmd[9].cmd = _conf.get_string("default", "exec_cmd_9");
-
-	if(_conf.get_string("default", "auto_refocus") == "true") {
-		configuration._auto_refocus = true;
-	} else {
-		configuration._auto_refocus = false;
+	for (int i = 0; i < 10; ++i) {
+		auto key = string{"bind_cmd_"} + std::to_string(i);
+		bind_cmd[i] = _conf.get_string("default", key.c_str());
 	}
 
-	if(_conf.get_string("default", "enable_shade_windows") == "true") {
-		configuration._enable_shade_windows = true;
-	} else {
-		configuration._enable_shade_windows = false;
+	configuration._replace_wm = false;
+	_compile_configuration(_conf, configuration);
+
+}
+
+/**
+ * Parse every value used at runtime once, the rest of page read the typed
+ * fields of page_configuration_t instead of the string map of
+ * config_handler_t. Throw if a key is missing, leaving configuration in an
+ * undefined state, thus callers compile into a scratch snapshot.
+ **/
+void page_t::_compile_configuration(config_handler_t const & conf, page_configuration_t & configuration)
+{
+	auto get_bool = [&conf](char const * key) -> bool {
+		return conf.get_string("default", key) == "true";
+	};
+
+	configuration._theme_dir = conf.get_string("default", "theme_dir");
+	configuration._theme_engine = conf.get_string("default", "theme_engine");
+
+	for (int i = 0; i < 10; ++i) {
+		auto key = string{"exec_cmd_"} + std::to_string(i);
+		configuration._exec_cmd[i] = conf.get_string("default", key.c_str());
 	}
 
-	if(_conf.get_string("default", "mouse_focus") == "true") {
-		configuration._mouse_focus = true;
-	} else {
-		configuration._mouse_focus = false;
+	configuration._auto_refocus = get_bool("auto_refocus");
+	configuration._enable_shade_windows = get_bool("enable_shade_windows");
+	configuration._mouse_focus = get_bool("mouse_focus");
+	configuration._menu_drop_down_shadow = get_bool("menu_drop_down_shadow");
+	configuration._render_component_actors = conf.get_string("default", "render_backend") == "actors";
+	configuration._fade_in_time = conf.get_long("compositor", "fade_in_time");
+}
+
+page_t::~page_t() {
+	if (_move_resize_repaint_func_id != 0)
+		clutter_threads_remove_repaint_func(_move_resize_repaint_func_id);
+	if (_conf_reload_timeout_id != 0)
+		g_source_remove(_conf_reload_timeout_id);
+	for (auto m: _conf_monitors) {
+		g_disconnect_from_obj(m);
+		g_object_unref(m);
 	}
+	_clear_workspace_switch_popup_cache();
+	// cleanup cairo, for valgrind happiness.
+	//cairo_debug_reset_static_data();
+}
 
-	if(_conf.get_string("default", "menu_drop_down_shadow") == "true") {
-		configuration._menu_drop_down_shadow = true;
+auto page_t::_create_theme(config_handler_t & conf, string const & engine) -> theme_t *
+{
+	if (engine == "tiny") {
+		cout << "using tiny theme engine" << endl;
+		return new tiny_theme_t{conf};
 	} else {
-		configuration._menu_drop_down_shadow = false;
+		/* The default theme engine */
+		cout << "using simple theme engine" << endl;
+		return new simple2_theme_t{conf};
+	}
+}
+
+void page_t::_set_theme(theme_t * theme)
+{
+	if (_theme != nullptr) {
+		disconnect(_theme->on_background_change);
+		delete _theme;
+	}
+	_theme = theme;
+	connect(_theme->on_background_change, this, &page_t::_handler_theme_background_change);
+}
+
+void page_t::_watch_configuration()
+{
+	for (auto const & f: _conf_files) {
+		auto file = g_file_new_for_path(f.c_str());
+		auto monitor = g_file_monitor_file(file, G_FILE_MONITOR_NONE, nullptr, nullptr);
+		g_object_unref(file);
+		if (monitor == nullptr)
+			continue;
+		g_connect(monitor, "changed", &page_t::_handler_conf_file_changed);
+		_conf_monitors.push_back(monitor);
 	}
+}
 
-	configuration._fade_in_time = _conf.get_long("compositor", "fade_in_time");
+void page_t::_handler_conf_file_changed(GFileMonitor * monitor, GFile * file, GFile * other_file, GFileMonitorEvent event)
+{
+	if (event == G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED)
+		return;
 
+	/* editors write files in several steps, wait for the last one */
+	if (_conf_reload_timeout_id != 0)
+		g_source_remove(_conf_reload_timeout_id);
+	_conf_reload_timeout_id = g_timeout_add(200, &page_t::_conf_reload_timeout, this);
 }
 
-page_t::~page_t() {
-	// cleanup cairo, for valgrind happiness.
-	//cairo_debug_reset_static_data();
+gboolean page_t::_conf_reload_timeout(gpointer data)
+{
+	auto ths = reinterpret_cast<page_t *>(data);
+	ths->_conf_reload_timeout_id = 0;
+	ths->_reload_configuration();
+	return FALSE;
+}
+
+/**
+ * Reload every configuration file. Nothing is changed unless the files
+ * are valid and the new theme, if needed, could be built, then the new
+ * snapshot replace the old one in one step. The theme is rebuilt only
+ * when its configuration changed.
+ **/
+void page_t::_reload_configuration()
+{
+	config_handler_t conf;
+	page_configuration_t next;
+	theme_t * theme = nullptr;
+
+	try {
+		for (auto const & f: _conf_files)
+			conf.merge_from_file_if_exist(f);
+		_compile_configuration(conf, next);
+		if (next._theme_engine != configuration._theme_engine
+				or next._theme_dir != configuration._theme_dir
+				or not conf.same_group(_conf, "simple_theme"))
+			theme = _create_theme(conf, next._theme_engine);
+	} catch (std::exception & e) {
+		log(LOG_NONE, "configuration not reloaded: %s\n", e.what());
+		return;
+	}
+
+	log(LOG_NONE, "configuration reloaded%s\n", theme?", with a new theme":"");
+
+	next._replace_wm = configuration._replace_wm;
+	_conf = conf;
+	configuration = next;
+
+	if (theme == nullptr)
+		return;
+
+	_set_theme(theme);
+	_clear_workspace_switch_popup_cache();
+	update_viewport_layout();
+	for (auto w: _workspace_list) {
+		for (auto n: w->gather_children_root_first<notebook_t>())
+			n->update_theme();
+	}
+	_update_workspace_switch_popup_cache();
+	_handler_theme_background_change(_theme);
 }
 
 void page_t::_handler_plugin_start()
@@ -317,16 +413,10 @@ void page_t::_handler_plugin_start()
 	_screen = meta_plugin_get_screen(_plugin);
 	_display = meta_screen_get_display(_screen);
 
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 
-	if (_theme_engine == "tiny") {
-		cout << "using tiny theme engine" << endl;
-		_theme = new tiny_theme_t{_conf};
-	} else {
-		/* The default theme engine */
-		cout << "using simple theme engine" << endl;
-		_theme = new simple2_theme_t{_conf};
-	}
+	_set_theme(_create_theme(_conf, configuration._theme_engine));
+	_watch_configuration();
 
 	MetaRectangle area;
 	auto workspace_list = meta_screen_get_workspaces(_screen);
@@ -343,6 +433,7 @@ void page_t::_handler_plugin_start()
 	_current_workspace = lookup_workspace(meta_screen_get_active_workspace(_screen));
 
 	_theme->update(area.width, area.height);
+	_update_workspace_switch_popup_cache();
 
 //	{
 //		auto windows = meta_get_window_actors(_screen);
@@ -367,7 +458,7 @@ void page_t::_handler_plugin_start()
 	auto xparent = clutter_actor_get_parent(window_group);
 
 
-	log::printf("wndow-group = %p, xparent = %p, stage = %p\n", window_group, xparent, stage);
+	log(LOG_PLUGIN, "wndow-group = %p, xparent = %p, stage = %p\n", window_group, xparent, stage);
 	_viewport_group = clutter_actor_new();
 	clutter_actor_show(_viewport_group);
 
@@ -421,8 +512,8 @@ void page_t::_handler_plugin_start()
 
 void page_t::_handler_plugin_minimize(ShellWM * wm, MetaWindowActor * actor)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
-	log::printf("meta_window = %p\n", meta_window_actor_get_meta_window(actor));
+	log(LOG_MANAGE, "call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MANAGE, "meta_window = %p\n", meta_window_actor_get_meta_window(actor));
 
 	auto mw = lookup_client_managed_with(actor);
 	if (not mw) {
@@ -443,35 +534,35 @@ void page_t::_handler_plugin_minimize(ShellWM * wm, MetaWindowActor * actor)
 
 void page_t::_handler_plugin_unminimize(ShellWM * wm, MetaWindowActor * actor)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MANAGE, "call %s\n", __PRETTY_FUNCTION__);
 	shell_wm_completed_unminimize(wm, actor);
 }
 
 void page_t::_handler_plugin_size_changed(ShellWM * wm, MetaWindowActor * window_actor)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_CONFIGURE_REQUEST, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_plugin_size_change(ShellWM * wm, MetaWindowActor * window_actor, MetaSizeChange const which_change, MetaRectangle * old_frame_rect, MetaRectangle * old_buffer_rect)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_CONFIGURE_REQUEST, "call %s\n", __PRETTY_FUNCTION__);
 
 	auto meta_window = meta_window_actor_get_meta_window(window_actor);
-	log::printf("olf_frame_rect x=%d, y=%d, w=%d, h=%d\n", old_frame_rect->x, old_frame_rect->y, old_frame_rect->width, old_frame_rect->height);
-	log::printf("old_buffer_rect x=%d, y=%d, w=%d, h=%d\n", old_buffer_rect->x, old_buffer_rect->y, old_buffer_rect->width, old_buffer_rect->height);
-	log::printf("meta_window = %p\n", meta_window);
+	log(LOG_CONFIGURE_REQUEST, "olf_frame_rect x=%d, y=%d, w=%d, h=%d\n", old_frame_rect->x, old_frame_rect->y, old_frame_rect->width, old_frame_rect->height);
+	log(LOG_CONFIGURE_REQUEST, "old_buffer_rect x=%d, y=%d, w=%d, h=%d\n", old_buffer_rect->x, old_buffer_rect->y, old_buffer_rect->width, old_buffer_rect->height);
+	log(LOG_CONFIGURE_REQUEST, "meta_window = %p\n", meta_window);
 	MetaRectangle new_rect;
 	meta_window_get_frame_rect(meta_window, &new_rect);
-	log::printf("new_frame_rect x=%d, y=%d, w=%d, h=%d\n", new_rect.x, new_rect.y, new_rect.width, new_rect.height);
+	log(LOG_CONFIGURE_REQUEST, "new_frame_rect x=%d, y=%d, w=%d, h=%d\n", new_rect.x, new_rect.y, new_rect.width, new_rect.height);
 	switch(which_change) {
 	case META_SIZE_CHANGE_MAXIMIZE:
-		log::printf("META_SIZE_CHANGE_MAXIMIZE\n");
+		log(LOG_CONFIGURE_REQUEST, "META_SIZE_CHANGE_MAXIMIZE\n");
 		break;
 	case META_SIZE_CHANGE_UNMAXIMIZE:
-		log::printf("META_SIZE_CHANGE_UNMAXIMIZE\n");
+		log(LOG_CONFIGURE_REQUEST, "META_SIZE_CHANGE_UNMAXIMIZE\n");
 		break;
 	case META_SIZE_CHANGE_FULLSCREEN:
-		log::printf("META_SIZE_CHANGE_FULLSCREEN\n");
+		log(LOG_CONFIGURE_REQUEST, "META_SIZE_CHANGE_FULLSCREEN\n");
 	{
 		auto mw = lookup_client_managed_with(window_actor);
 		if (mw) {
@@ -484,7 +575,7 @@ void page_t::_handler_plugin_size_change(ShellWM * wm, MetaWindowActor * window_
 	}
 		break;
 	case META_SIZE_CHANGE_UNFULLSCREEN:
-		log::printf("META_SIZE_CHANGE_UNFULLSCREEN\n");
+		log(LOG_CONFIGURE_REQUEST, "META_SIZE_CHANGE_UNFULLSCREEN\n");
 	{
 		auto mw = lookup_client_managed_with(window_actor);
 		if (mw) {
@@ -497,7 +588,7 @@ void page_t::_handler_plugin_size_change(ShellWM * wm, MetaWindowActor * window_
 	}
 		break;
 	default:
-		log::printf("UNKKNOWN %d\n", static_cast<int>(which_change));
+		log(LOG_CONFIGURE_REQUEST, "UNKKNOWN %d\n", static_cast<int>(which_change));
 		break;
 	}
 
@@ -506,7 +597,7 @@ void page_t::_handler_plugin_size_change(ShellWM * wm, MetaWindowActor * window_
 
 void page_t::_handler_plugin_map(ShellWM * wm, MetaWindowActor * window_actor)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MANAGE, "call %s\n", __PRETTY_FUNCTION__);
 	MetaWindowType type;
 	ClutterActor * actor = CLUTTER_ACTOR(window_actor);
 	MetaWindow *meta_window = meta_window_actor_get_meta_window(window_actor);
@@ -518,10 +609,12 @@ void page_t::_handler_plugin_map(ShellWM * wm, MetaWindowActor * window_actor)
 	type = meta_window_get_window_type(meta_window);
 
 	if (type == META_WINDOW_NORMAL) {
-		log::printf("normal window\n");
+		log(LOG_MANAGE, "normal window\n");
 
 		auto mw = make_shared<client_managed_t>(this, window_actor);
 		_net_client_list.push_back(mw);
+		_client_by_meta_window[mw->meta_window()] = mw;
+		_client_by_meta_window_actor[mw->meta_window_actor()] = mw;
 
 		auto meta_window = meta_window_actor_get_meta_window(window_actor);
 		g_connect(meta_window, "focus", &page_t::_handler_meta_window_focus);
@@ -537,7 +630,7 @@ void page_t::_handler_plugin_map(ShellWM * wm, MetaWindowActor * window_actor)
 
 void page_t::_handler_plugin_destroy(ShellWM * wm, MetaWindowActor * actor)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MANAGE, "call %s\n", __PRETTY_FUNCTION__);
 	auto mw = lookup_client_managed_with(actor);
 	if (mw) {
 		unmanage(mw);
@@ -549,7 +642,7 @@ void page_t::_handler_plugin_destroy(ShellWM * wm, MetaWindowActor * actor)
 
 void page_t::_handler_plugin_switch_workspace(ShellWM * wm, gint from, gint to, MetaMotionDirection direction)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_WORKSPACE, "call %s\n", __PRETTY_FUNCTION__);
 
 	switch_to_workspace(to, 0);
 
@@ -558,32 +651,32 @@ void page_t::_handler_plugin_switch_workspace(ShellWM * wm, gint from, gint to,
 
 void page_t::_handler_plugin_show_tile_preview(ShellWM * wm, MetaWindow * window, MetaRectangle *tile_rect, int tile_monitor_number)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_plugin_hide_tile_preview(ShellWM * wm)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_plugin_show_window_menu(ShellWM * wm, MetaWindow * window, MetaWindowMenuType menu, MetaRectangle * rect)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_plugin_show_window_menu_for_rect(ShellWM * wm, MetaWindow * window, MetaWindowMenuType menu, MetaRectangle * rect)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_plugin_kill_window_effects(ShellWM * wm, MetaWindowActor * actor)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_plugin_kill_switch_workspace(ShellWM * wm)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_WORKSPACE, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 auto page_t::_handler_plugin_xevent_filter(ShellWM * wm, XEvent * event) -> gboolean
@@ -594,26 +687,26 @@ auto page_t::_handler_plugin_xevent_filter(ShellWM * wm, XEvent * event) -> gboo
 
 auto page_t::_handler_plugin_keybinding_filter(ShellWM * wm, MetaKeyBinding * binding) -> gboolean
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
-	log::printf("call %s %d\n", meta_key_binding_get_name(binding), meta_key_binding_get_modifiers(binding));
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s %d\n", meta_key_binding_get_name(binding), meta_key_binding_get_modifiers(binding));
 	return FALSE;
 }
 
 void page_t::_handler_plugin_confirm_display_change(ShellWM * wm)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 	meta_plugin_complete_display_change(_plugin, TRUE);
 }
 
 auto page_t::_handler_plugin_create_close_dialog(ShellWM * wm, MetaWindow * window) -> MetaCloseDialog *
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 	return NULL;
 }
 
 auto page_t::_handler_plugin_create_inhibit_shortcuts_dialog(ShellWM * wm, MetaWindow * window) -> MetaInhibitShortcutsDialog *
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 	return NULL;
 }
 
@@ -679,59 +772,59 @@ auto page_t::_handler_stage_key_release_event(ClutterActor * actor, ClutterEvent
 
 void page_t::_handler_screen_in_fullscreen_changed(MetaScreen *metascreen)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_SCREEN, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_screen_monitors_changed(MetaScreen * screen)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_SCREEN, "call %s\n", __PRETTY_FUNCTION__);
 	update_viewport_layout();
 }
 
 void page_t::_handler_screen_restacked(MetaScreen * screen)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_RESTACK, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_screen_startup_sequence_changed(MetaScreen * screen, gpointer arg1)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_SCREEN, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_screen_window_entered_monitor(MetaScreen *metascreen, gint arg1, MetaWindow *arg2)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_SCREEN, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_screen_window_left_monitor(MetaScreen *metascreen, gint arg1, MetaWindow *arg2)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_SCREEN, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_screen_workareas_changed(MetaScreen * screen)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_SCREEN, "call %s\n", __PRETTY_FUNCTION__);
 	update_viewport_layout();
 }
 
 void page_t::_handler_screen_workspace_added(MetaScreen * screen, gint arg1)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_WORKSPACE, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_screen_workspace_removed(MetaScreen * screen, gint arg1)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_WORKSPACE, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_screen_workspace_switched(MetaScreen * screen, gint arg1, gint arg2, MetaMotionDirection arg3)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_WORKSPACE, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_meta_window_focus(MetaWindow * window)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_FOCUS, "call %s\n", __PRETTY_FUNCTION__);
 
 	auto w = current_workspace();
 	if (not w->_net_active_window.expired()) {
@@ -760,7 +853,7 @@ void page_t::_handler_meta_window_focus(MetaWindow * window)
 
 void page_t::_handler_window_unmanaged(MetaWindow * window)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MANAGE, "call %s\n", __PRETTY_FUNCTION__);
 	auto mw = lookup_client_managed_with(window);
 	if(mw) {
 		unmanage(mw);
@@ -769,46 +862,48 @@ void page_t::_handler_window_unmanaged(MetaWindow * window)
 
 void page_t::_handler_meta_display_accelerator_activated(MetaDisplay * metadisplay, guint arg1, guint arg2, guint arg3)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_meta_display_grab_op_begin(MetaDisplay * metadisplay, MetaScreen * arg1, MetaWindow * arg2, MetaGrabOp arg3)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_GRAB, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::_handler_meta_display_grab_op_end(MetaDisplay * metadisplay, MetaScreen * arg1, MetaWindow * arg2, MetaGrabOp arg3)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_GRAB, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 auto page_t::_handler_meta_display_modifiers_accelerator_activated(MetaDisplay * display) -> gboolean
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 	return FALSE;
 }
 
 void page_t::_handler_meta_display_overlay_key(MetaDisplay * display)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_KEYBINDING, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 auto page_t::_handler_meta_display_restart(MetaDisplay * display) -> gboolean
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_PLUGIN, "call %s\n", __PRETTY_FUNCTION__);
 	return FALSE;
 }
 
 void page_t::_handler_meta_display_window_created(MetaDisplay * display, MetaWindow * window)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MANAGE, "call %s\n", __PRETTY_FUNCTION__);
 }
 
 void page_t::unmanage(client_managed_p mw)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_MANAGE, "call %s\n", __PRETTY_FUNCTION__);
 	assert(mw != nullptr);
 	_net_client_list.remove(mw);
+	_client_by_meta_window.erase(mw->meta_window());
+	_client_by_meta_window_actor.erase(mw->meta_window_actor());
 
 	/* if window is in move/resize/notebook move, do cleanup */
 	cleanup_grab();
@@ -1089,21 +1184,17 @@ void page_t::insert_as_floating(client_managed_p c, xcb_timestamp_t time) {
 }
 
 auto page_t::lookup_client_managed_with(MetaWindow * w) const -> client_managed_p {
-	for (auto & i: _net_client_list) {
-		if (i->meta_window() == w) {
-			return i;
-		}
-	}
+	auto x = _client_by_meta_window.find(w);
+	if (x != _client_by_meta_window.end())
+		return x->second;
 	return nullptr;
 }
 
 auto page_t::lookup_client_managed_with(MetaWindowActor * w) const -> client_managed_p
 {
-	for (auto & i: _net_client_list) {
-		if (i->meta_window_actor() == w) {
-			return i;
-		}
-	}
+	auto x = _client_by_meta_window_actor.find(w);
+	if (x != _client_by_meta_window_actor.end())
+		return x->second;
 	return nullptr;
 }
 
@@ -1142,48 +1233,92 @@ void page_t::switch_to_workspace(unsigned int workspace_id, xcb_timestamp_t time
 		return;
 
 	if (workspace != current_workspace()) {
-		log::printf("switch to workspace #%p\n", meta_workspace);
+		log(LOG_WORKSPACE, "switch to workspace #%p\n", meta_workspace);
 		start_switch_to_workspace_animation(workspace);
 		_current_workspace = workspace;
 		update_workspace_visibility(time);
 	}
 }
 
-void page_t::start_switch_to_workspace_animation(workspace_p workspace)
+auto page_t::_workspace_switch_popup(string const & name) -> workspace_switch_popup_t const &
 {
-	auto pix = theme()->workspace_switch_popup(workspace->name());
+	auto x = _workspace_switch_popup_cache.find(name);
+	if (x != _workspace_switch_popup_cache.end())
+		return x->second;
 
-	log::printf("xxx pos x=%f, y=%f\n", clutter_actor_get_x(_overlay_group), clutter_actor_get_y(_overlay_group));
+	auto pix = theme()->workspace_switch_popup(name);
 
-	for(auto const & v : workspace->get_viewports()) {
+	GError * err = NULL;
+	auto image = clutter_image_new();
+	if (not clutter_image_set_data(CLUTTER_IMAGE(image),
+			cairo_image_surface_get_data(pix),
+			cairo_image_surface_get_format(pix)==CAIRO_FORMAT_ARGB32
+				?COGL_PIXEL_FORMAT_RGBA_8888
+				:COGL_PIXEL_FORMAT_RGB_888,
+			cairo_image_surface_get_width(pix),
+			cairo_image_surface_get_height(pix),
+			cairo_image_surface_get_stride(pix),
+			&err
+	)) {
+		g_error("%s\n", err->message);
+	}
+
+	workspace_switch_popup_t popup{image,
+		cairo_image_surface_get_width(pix),
+		cairo_image_surface_get_height(pix)};
+	cairo_surface_destroy(pix);
+
+	return _workspace_switch_popup_cache.insert(make_pair(name, popup)).first->second;
+}
 
-		GError * err = NULL;
-		auto image = clutter_image_new();
-		if (not clutter_image_set_data(CLUTTER_IMAGE(image),
-				cairo_image_surface_get_data(pix),
-				cairo_image_surface_get_format(pix)==CAIRO_FORMAT_ARGB32
-					?COGL_PIXEL_FORMAT_RGBA_8888
-					:COGL_PIXEL_FORMAT_RGB_888,
-				cairo_image_surface_get_width(pix),
-				cairo_image_surface_get_height(pix),
-				cairo_image_surface_get_stride(pix),
-				&err
-		)) {
-			g_error("%s\n", err->message);
+/**
+ * Render the popup of every workspace name and drop popups of names that
+ * are no longer in use.
+ **/
+void page_t::_update_workspace_switch_popup_cache()
+{
+	set<string> names;
+	for (auto w: _workspace_list)
+		names.insert(w->name());
+
+	for (auto x = _workspace_switch_popup_cache.begin(); x != _workspace_switch_popup_cache.end();) {
+		if (names.count(x->first)) {
+			++x;
+		} else {
+			g_object_unref(x->second.image);
+			x = _workspace_switch_popup_cache.erase(x);
 		}
+	}
+
+	for (auto const & name: names)
+		_workspace_switch_popup(name);
+}
 
+/** must be called when the theme that rendered the popups change **/
+void page_t::_clear_workspace_switch_popup_cache()
+{
+	for (auto & x: _workspace_switch_popup_cache)
+		g_object_unref(x.second.image);
+	_workspace_switch_popup_cache.clear();
+}
+
+void page_t::start_switch_to_workspace_animation(workspace_p workspace)
+{
+	/* a renamed workspace miss the cache, refresh it before */
+	if (not _workspace_switch_popup_cache.count(workspace->name()))
+		_update_workspace_switch_popup_cache();
+	auto const & popup = _workspace_switch_popup(workspace->name());
+
+	for(auto const & v : workspace->get_viewports()) {
 		auto loc = v->allocation();
 		auto actor = clutter_actor_new();
-		clutter_actor_set_size(actor, cairo_image_surface_get_width(pix),
-				cairo_image_surface_get_height(pix));
-		clutter_actor_set_content(actor, image);
+		clutter_actor_set_size(actor, popup.width, popup.height);
+		clutter_actor_set_content(actor, popup.image);
 		clutter_actor_set_content_scaling_filters(actor,
 				CLUTTER_SCALING_FILTER_NEAREST, CLUTTER_SCALING_FILTER_NEAREST);
 		clutter_actor_set_position(actor,
-				loc.x + (loc.w-cairo_image_surface_get_width(pix))/2,
-				loc.y + (loc.h-cairo_image_surface_get_height(pix))/2);
-
-		log::printf("yyy pos x=%f, y=%f\n", clutter_actor_get_x(actor), clutter_actor_get_y(actor));
+				loc.x + (loc.w-popup.width)/2,
+				loc.y + (loc.h-popup.height)/2);
 
 		clutter_actor_set_opacity(actor, 255);
 		clutter_actor_insert_child_above(_overlay_group, actor, NULL);
@@ -1205,11 +1340,8 @@ void page_t::start_switch_to_workspace_animation(workspace_p workspace)
 		clutter_actor_set_opacity(actor, 0);
 		clutter_actor_restore_easing_state(actor);
 
-		g_object_unref(image);
-
 	}
 
-	cairo_surface_destroy(pix);
 	schedule_repaint();
 
 }
@@ -1231,7 +1363,7 @@ void page_t::update_workspace_visibility(xcb_timestamp_t time) {
 /* Inspired from openbox */
 void page_t::run_cmd(std::string const & cmd_with_args)
 {
-	log::printf("executing %s\n", cmd_with_args.c_str());
+	log(LOG_KEYBINDING, "executing %s\n", cmd_with_args.c_str());
 
     GError *e;
     gchar **argv = NULL;
@@ -1242,13 +1374,13 @@ void page_t::run_cmd(std::string const & cmd_with_args)
 
     cmd = g_filename_from_utf8(cmd_with_args.c_str(), -1, NULL, NULL, NULL);
     if (!cmd) {
-    	log::printf("Failed to convert the path \"%s\" from utf8\n", cmd_with_args.c_str());
+    	log(LOG_NONE, "Failed to convert the path \"%s\" from utf8\n", cmd_with_args.c_str());
         return;
     }
 
     e = NULL;
     if (!g_shell_parse_argv(cmd, NULL, &argv, &e)) {
-    	log::printf("%s\n", e->message);
+    	log(LOG_NONE, "%s\n", e->message);
         g_error_free(e);
     } else {
         gchar *program = NULL;
@@ -1260,7 +1392,7 @@ void page_t::run_cmd(std::string const & cmd_with_args)
                            G_SPAWN_DO_NOT_REAP_CHILD),
                            NULL, NULL, NULL, &e);
         if (!ok) {
-        	log::printf("%s\n", e->message);
+        	log(LOG_NONE, "%s\n", e->message);
             g_error_free(e);
         }
 
@@ -1295,19 +1427,19 @@ auto page_t::dpy() const -> MetaDisplay *
 
 void page_t::grab_start(shared_ptr<grab_handler_t> handler, guint32 time)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_GRAB, "call %s\n", __PRETTY_FUNCTION__);
 
 	assert(_grab_handler == nullptr);
 	if (meta_plugin_begin_modal(_plugin, (MetaModalOptions)0, time)) {
 		_grab_handler = handler;
 	} else {
-		log::printf("FAIL GRAB\n");
+		log(LOG_NONE, "FAIL GRAB\n");
 	}
 }
 
 void page_t::grab_stop(guint32 time)
 {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+	log(LOG_GRAB, "call %s\n", __PRETTY_FUNCTION__);
 
 	assert(_grab_handler != nullptr);
 	_grab_handler = nullptr;
@@ -1337,12 +1469,13 @@ void page_t::create_workspace(guint time) {
 	d->show();
 
 	update_viewport_layout();
+	_update_workspace_switch_popup_cache();
 
 	if(d != current_workspace()) {
-		for (auto &x: current_workspace()->gather_children_root_first<view_t>()) {
+		for (auto x: current_workspace()->registered<view_t>()) {
 			if (meta_window_is_always_on_all_workspaces(x->_client->meta_window())) {
 				/** TODO: insert desktop **/
-				auto const & type = typeid(*(x.get()));
+				auto const & type = typeid(*x);
 				if (type == typeid(view_notebook_t)) {
 					d->insert_as_notebook(x->_client, XCB_CURRENT_TIME);
 				} else if (type == typeid(view_floating_t)) {
@@ -1396,6 +1529,58 @@ auto page_t::net_client_list() -> list<client_managed_p> const &
 	return _net_client_list;
 }
 
+void page_t::queue_move_resize(client_managed_p c)
+{
+	if (c->_move_resize_pending)
+		return;
+	c->_move_resize_pending = true;
+	_pending_move_resize.push_back(c);
+
+	if (_move_resize_repaint_func_id == 0) {
+		_move_resize_repaint_func_id = clutter_threads_add_repaint_func_full(
+				CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+				&page_t::_move_resize_repaint_func, this, nullptr);
+		schedule_repaint();
+	}
+}
+
+gboolean page_t::_move_resize_repaint_func(gpointer data)
+{
+	auto ths = reinterpret_cast<page_t *>(data);
+	/* returning FALSE remove the repaint func, a move/resize may queue
+	 * others, they will be applied at next frame */
+	ths->_move_resize_repaint_func_id = 0;
+	vector<client_managed_w> pending;
+	pending.swap(ths->_pending_move_resize);
+	for (auto & x: pending) {
+		auto c = x.lock();
+		if (c == nullptr or not c->_move_resize_pending)
+			continue;
+		c->_move_resize_pending = false;
+		auto const & p = c->_absolute_position;
+		/* skip windows that are already in place */
+		MetaRectangle current;
+		meta_window_get_frame_rect(c->meta_window(), &current);
+		if (current.x == p.x and current.y == p.y
+				and current.width == p.w and current.height == p.h)
+			continue;
+		meta_window_move_resize_frame(c->meta_window(), FALSE, p.x, p.y, p.w, p.h);
+	}
+	return FALSE;
+}
+
+/**
+ * The background is decoded asynchronously, redraw everything when ready.
+ **/
+void page_t::_handler_theme_background_change(theme_t * theme)
+{
+	for (auto w: _workspace_list) {
+		for (auto v: w->get_viewports())
+			v->queue_redraw();
+	}
+	schedule_repaint();
+}
+
 void page_t::schedule_repaint()
 {
 	auto stage = meta_get_stage_for_screen(_screen);
@@ -1422,20 +1607,68 @@ void page_t::sync_tree_view()
 		return;
 	guard = true;
 
-	clutter_actor_remove_all_children(_viewport_group);
-	auto viewport = current_workspace()->gather_children_root_first<viewport_t>();
-	for (auto x : viewport) {
+	vector<ClutterActor *> viewport_views;
+	for (auto x : current_workspace()->registered<viewport_t>()) {
 		if (x->get_default_view()) {
-			clutter_actor_add_child(_viewport_group, x->get_default_view());
+			viewport_views.push_back(x->get_default_view());
 		}
 	}
 
-	auto window_group = meta_get_window_group_for_screen(_screen);
-	auto children = current_workspace()->gather_children_root_first<view_t>();
-	log::printf("found %lu children\n", children.size());
+	/* only rebuild the viewport group if viewports changed */
+	bool viewport_changed = false;
+	auto current_views = clutter_actor_get_children(_viewport_group);
+	auto it = current_views;
+	for (auto x : viewport_views) {
+		if (it == nullptr or it->data != x) {
+			viewport_changed = true;
+			break;
+		}
+		it = it->next;
+	}
+	if (it != nullptr)
+		viewport_changed = true;
+	g_list_free(current_views);
+
+	if (viewport_changed) {
+		clutter_actor_remove_all_children(_viewport_group);
+		for (auto x : viewport_views) {
+			clutter_actor_add_child(_viewport_group, x);
+		}
+	}
+
+	auto const & children = current_workspace()->registered<view_t>();
+	log(LOG_RESTACK, "found %lu children\n", children.size());
+
+	/**
+	 * meta_window_raise put a window on top of the stack, thus the windows
+	 * that do not need to be raised are the longest prefix of the new stack
+	 * found in the same order in the previous stack, all others are raised
+	 * in order.
+	 **/
+	auto last = _last_stack.begin();
+	auto first_raised = children.begin();
+	for (; first_raised != children.end(); ++first_raised) {
+		while (last != _last_stack.end() and last->lock().get() != *first_raised)
+			++last;
+		if (last == _last_stack.end())
+			break;
+		++last;
+	}
+
+	log(LOG_RESTACK, "raise %lu of %lu children\n",
+			static_cast<unsigned long>(std::distance(first_raised, children.end())),
+			children.size());
+	for (auto x = first_raised; x != children.end(); ++x) {
+		log(LOG_RESTACK, "raise %p\n", (*x)->_client->meta_window());
+		meta_window_raise((*x)->_client->meta_window());
+	}
+
+	_last_stack.clear();
+	for (auto x: children) {
+		_last_stack.push_back(x->shared_from_this());
+	}
+
 	for(auto x: children) {
-		log::printf("raise %p\n", x->_client->meta_window());
-		meta_window_raise(x->_client->meta_window());
 		meta_window_actor_sync_visibility(x->_client->meta_window_actor());
 	}
 
@@ -1443,6 +1676,18 @@ void page_t::sync_tree_view()
 
 }
 
+/**
+ * A window has been raised, update the last known stacking order to match
+ * the actual stack.
+ **/
+void page_t::notify_client_raised(client_managed_t * c)
+{
+	stable_partition(_last_stack.begin(), _last_stack.end(), [c](view_w const & x) -> bool {
+		auto v = x.lock();
+		return v == nullptr or v->_client.get() != c;
+	});
+}
+
 bool page_t::has_grab_handler()
 {
 	return (_grab_handler != nullptr);
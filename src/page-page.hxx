@@ -19,8 +19,11 @@ extern "C" {
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <array>
 
+#include <gio/gio.h>
+
 #include "page-time.hxx"
 
 #include "page-config-handler.hxx"
@@ -31,8 +34,6 @@ extern "C" {
 
 #include "page-client-managed.hxx"
 
-#include "page-popup-split.hxx"
-
 #include "page-dropdown-menu.hxx"
 
 #include "page-page-component.hxx"
@@ -73,11 +74,6 @@ enum process_mode_e {
 	PROCESS_ALT_TAB						// when alt-tab running
 };
 
-struct key_bind_cmd_t {
-	key_desc_t key;
-	string cmd;
-};
-
 class page_t:
 		public connectable_t,
 		public g_connectable_t
@@ -126,9 +122,6 @@ public:
 
 	list<xcb_atom_t> supported_list;
 
-	string page_base_dir;
-	string _theme_engine;
-
 	key_desc_t bind_page_quit;
 	key_desc_t bind_toggle_fullscreen;
 	key_desc_t bind_toggle_compositor;
@@ -148,7 +141,7 @@ public:
 	key_desc_t bind_debug_3;
 	key_desc_t bind_debug_4;
 
-	array<key_bind_cmd_t, 10> bind_cmd;
+	array<key_desc_t, 10> bind_cmd;
 
 	bool _schedule_repaint;
 	uint32_t frame_alarm;
@@ -160,8 +153,49 @@ private:
 
 	/** store all client in mapping order, older first **/
 	list<client_managed_p> _net_client_list;
+
+	/** index of _net_client_list, for fast lookup from mutter objects **/
+	unordered_map<MetaWindow *, client_managed_p> _client_by_meta_window;
+	unordered_map<MetaWindowActor *, client_managed_p> _client_by_meta_window_actor;
 	list<view_w> _global_focus_history;
 
+	/** last stacking order applied by sync_tree_view, bottom first **/
+	vector<view_w> _last_stack;
+
+	/** clients to move/resize before the next frame **/
+	vector<client_managed_w> _pending_move_resize;
+	guint _move_resize_repaint_func_id;
+
+	static gboolean _move_resize_repaint_func(gpointer data);
+
+	void _handler_theme_background_change(theme_t * theme);
+
+	/** configuration files, lower priority first, watched for hot reload **/
+	vector<string> _conf_files;
+	vector<GFileMonitor *> _conf_monitors;
+	guint _conf_reload_timeout_id;
+
+	static void _compile_configuration(config_handler_t const & conf, page_configuration_t & configuration);
+	static auto _create_theme(config_handler_t & conf, string const & engine) -> theme_t *;
+	void _set_theme(theme_t * theme);
+	void _watch_configuration();
+	void _reload_configuration();
+	void _handler_conf_file_changed(GFileMonitor * monitor, GFile * file, GFile * other_file, GFileMonitorEvent event);
+	static gboolean _conf_reload_timeout(gpointer data);
+
+	/** workspace switch popups, rendered and uploaded once per name **/
+	struct workspace_switch_popup_t {
+		ClutterContent * image;
+		int width;
+		int height;
+	};
+
+	map<string, workspace_switch_popup_t> _workspace_switch_popup_cache;
+
+	auto _workspace_switch_popup(string const & name) -> workspace_switch_popup_t const &;
+	void _update_workspace_switch_popup_cache();
+	void _clear_workspace_switch_popup_cache();
+
 	int _left_most_border;
 	int _top_most_border;
 
@@ -315,6 +349,12 @@ public:
 	auto lookup_client_managed_with(MetaWindowActor * actor) const -> client_managed_p;
 	auto lookup_workspace(MetaWorkspace * w) const -> workspace_p;
 
+	/**
+	 * Move/resize the MetaWindow of c to its _absolute_position before the
+	 * next frame, multiple requests within a frame are merged.
+	 **/
+	void queue_move_resize(client_managed_p c);
+
 	void raise_child(shared_ptr<tree_t> t);
 	void process_notebook_client_menu(shared_ptr<client_managed_t> c, int selected);
 
@@ -383,6 +423,7 @@ public:
 
 	void activate(view_p c, xcb_timestamp_t time);
 	void sync_tree_view();
+	void notify_client_raised(client_managed_t * c);
 
 	bool has_grab_handler();
 
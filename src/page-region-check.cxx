@@ -0,0 +1,140 @@
+/*
+ * page-region-check.cxx
+ *
+ * copyright (2010-2014) Benoit Gschwind
+ *
+ * This code is licensed under the GPLv3. see COPYING file for more details.
+ *
+ * Check region_t operations against a per-pixel reference, on random sets
+ * of rectangles that overlap, touch or sit side by side, and check that
+ * region_t::from_rects builds the same region as repeated unions.
+ *
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "page-region.hxx"
+
+using namespace std;
+using namespace page;
+
+static int const width = 64;
+static int const height = 48;
+
+/**
+ * Per-pixel reference of a region.
+ **/
+struct check_bitmap_t {
+	vector<bool> pixels;
+
+	check_bitmap_t() : pixels(width * height, false) { }
+
+	void add(i_rect_t<int> const & r) {
+		for(int y = r.y; y < r.y + r.h; ++y)
+			for(int x = r.x; x < r.x + r.w; ++x)
+				pixels[y * width + x] = true;
+	}
+
+};
+
+static unsigned check_seed = 1;
+
+static int check_random(int n)
+{
+	check_seed = check_seed * 1103515245u + 12345u;
+	return (check_seed >> 8) % n;
+}
+
+/**
+ * Random rectangles on a coarse grid, thus walls of different rectangles
+ * often coincide.
+ **/
+static auto check_rects(int count) -> vector<i_rect_t<int>>
+{
+	vector<i_rect_t<int>> ret;
+	for(int k = 0; k < count; ++k) {
+		int w = 4 * (1 + check_random(6));
+		int h = 4 * (1 + check_random(6));
+		ret.push_back(i_rect_t<int>(4 * check_random((width - w) / 4 + 1),
+				4 * check_random((height - h) / 4 + 1), w, h));
+	}
+	return ret;
+}
+
+static auto check_union(vector<i_rect_t<int>> const & rects) -> region
+{
+	region ret;
+	for(auto const & x: rects)
+		ret += region{x};
+	return ret;
+}
+
+static auto check_bitmap(vector<i_rect_t<int>> const & rects) -> check_bitmap_t
+{
+	check_bitmap_t ret;
+	for(auto const & x: rects)
+		ret.add(x);
+	return ret;
+}
+
+static bool check_pixels(char const * name, int test, region r,
+		check_bitmap_t const & a, check_bitmap_t const & b, function<bool(bool, bool)> f)
+{
+	for(int y = 0; y < height; ++y) {
+		for(int x = 0; x < width; ++x) {
+			bool expected = f(a.pixels[y * width + x], b.pixels[y * width + x]);
+			if(r.is_inside(x, y) != expected) {
+				printf("case %d: %s differs at (%d,%d): %s\n", test, name, x, y,
+						r.to_string().c_str());
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	int failures = 0;
+
+	for(int test = 0; test < 2000; ++test) {
+		auto ra = check_rects(1 + check_random(12));
+		auto rb = check_rects(1 + check_random(12));
+		auto a = check_union(ra);
+		auto b = check_union(rb);
+		auto bitmap_a = check_bitmap(ra);
+		auto bitmap_b = check_bitmap(rb);
+
+		bool ok = true;
+		ok = ok and check_pixels("union", test, a, bitmap_a, bitmap_a,
+				[](bool x, bool) { return x; });
+		ok = ok and check_pixels("a + b", test, a + b, bitmap_a, bitmap_b,
+				[](bool x, bool y) { return x or y; });
+		ok = ok and check_pixels("a - b", test, a - b, bitmap_a, bitmap_b,
+				[](bool x, bool y) { return x and not y; });
+		ok = ok and check_pixels("a & b", test, a & b, bitmap_a, bitmap_b,
+				[](bool x, bool y) { return x and y; });
+
+		/* both must give the same bands, not only the same pixels */
+		auto built = region::from_rects(ra);
+		if(built.to_string() != a.to_string()) {
+			printf("case %d: from_rects gives %s, repeated union gives %s\n", test,
+					built.to_string().c_str(), a.to_string().c_str());
+			ok = false;
+		}
+
+		if(not ok)
+			++failures;
+	}
+
+	if(failures > 0) {
+		printf("%d failing cases\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
+
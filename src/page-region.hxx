@@ -16,6 +16,7 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <limits>
 
 #include "page-box.hxx"
 
@@ -76,6 +77,32 @@ class region_t {
 	}
 
 
+	/**
+	 * Per thread scratch buffers reused by region operations, results are
+	 * built within them then copied into an exactly sized buffer.
+	 **/
+	struct _arena_t {
+		vector<int> data;
+		vector<int> merge;
+		vector<int> edges;
+		vector<i_rect_t<int>> rects;
+		vector<i_rect_t<int>> active;
+		vector<pair<int, int>> spans;
+	};
+
+	static _arena_t & _arena() {
+		static thread_local _arena_t arena;
+		return arena;
+	}
+
+	/* copy the region built in buffer to its own data */
+	void _assign_data(int const * buffer, int size) {
+		if(_data != nullptr)
+			std::free(_data);
+		_data = reinterpret_cast<int*>(std::malloc(sizeof(int)*size));
+		std::copy(buffer, buffer + size, _data);
+	}
+
 	static bool _operator_union(bool a, bool b) {
 		return a or b;
 	}
@@ -202,7 +229,7 @@ class region_t {
 		if(_band_wall_count(prev_band) != _band_wall_count(next_band))
 			return false;
 
-		for(unsigned k = 0; k < _band_wall_count(prev_band); ++k) {
+		for(int k = 0; k < _band_wall_count(prev_band); ++k) {
 			if(_band_get_wall(prev_band, k) != _band_get_wall(next_band, k))
 				return false;
 		}
@@ -211,6 +238,48 @@ class region_t {
 	}
 
 
+	/* append the walls of band to band_r */
+	static void _append_walls(int const * band, int * band_r) {
+		std::copy(&_band_get_wall(band, 0),
+				&_band_get_wall(band, 0) + _band_wall_count(band),
+				&_band_get_wall(band_r, _band_wall_count(band_r)));
+		_band_wall_count(band_r) += _band_wall_count(band);
+	}
+
+	/**
+	 * Fast path of _merge_band, when a band is empty or both bands do not
+	 * overlap each wall of the result is a wall of only one band, thus the
+	 * result is a plain copy of walls. Return false if the fast path does
+	 * not apply.
+	 **/
+	template<typename F>
+	static bool _merge_band_disjoint(F f, int const * band_a, int const * band_b, int * band_r) {
+		int count_a = _band_wall_count(band_a);
+		int count_b = _band_wall_count(band_b);
+
+		int const * first = band_a;
+		int const * second = band_b;
+		bool keep_first = f(true, false);
+		bool keep_second = f(false, true);
+
+		if(count_a > 0 and count_b > 0) {
+			/* walls that touch must be merged, thus disjoint is strict */
+			if(_band_get_wall(band_b, count_b - 1) < _band_get_wall(band_a, 0)) {
+				std::swap(first, second);
+				std::swap(keep_first, keep_second);
+			} else if(not (_band_get_wall(band_a, count_a - 1) < _band_get_wall(band_b, 0))) {
+				return false;
+			}
+		}
+
+		_band_wall_count(band_r) = 0;
+		if(keep_first)
+			_append_walls(first, band_r);
+		if(keep_second)
+			_append_walls(second, band_r);
+		return true;
+	}
+
 	template<typename F>
 	static void _merge_band(F f, int const * band_a, int const * band_b, int * band_r) {
 		/* a fake empty band */
@@ -222,6 +291,9 @@ class region_t {
 		if(band_b == nullptr)
 			band_b = &fake_band[0];
 
+		if(_merge_band_disjoint(f, band_a, band_b, band_r))
+			return;
+
 		int wall_a = 0;
 		int wall_b = 0;
 
@@ -383,8 +455,7 @@ class region_t {
 
 	template<typename F>
 	static region_t _merge(F f, region_t const & a, region_t const & b) {
-		static int buffer_size = 0;
-		static int * buffer = nullptr;
+		auto & buffer = _arena().merge;
 
 		region_t r;
 
@@ -393,13 +464,15 @@ class region_t {
 		 * generate, knowing some parameters of a and b. I didn't thought
 		 * carefully at the question but I try to use a large margin.
 		 **/
-		int maxsize = 3 + 4*4*(a._band_count()+b._band_count())
+		size_t maxsize = 3 + 4*4*(a._band_count()+b._band_count())
 				+ 4*(a._band_count()+b._band_count())*(a._wall_count()+b._wall_count());
 
-		if(r._data != nullptr)
-			std::free(r._data);
+		if(buffer.size() < maxsize)
+			buffer.resize(maxsize);
 
-		r._data = reinterpret_cast<int*>(std::malloc(sizeof(int)*maxsize));
+		/* build the result within the scratch buffer */
+		int * result = r._data;
+		r._data = buffer.data();
 
 		int band_r = 0;
 		int wall_r_count = 0;
@@ -485,8 +558,8 @@ class region_t {
 		r._wall_count() = wall_r_count;
 
 		//cout << "xxx " << r.dump_data() << endl;
-		r._data = reinterpret_cast<int*>(std::realloc(r._data,
-				sizeof(int)*r._data_int_count()));
+		r._data = result;
+		r._assign_data(buffer.data(), 3 + 4 * band_r + wall_r_count);
 
 		return r;
 	}
@@ -539,10 +612,13 @@ public:
 	}
 
 	region_t(vector<int> const & l) : _data{nullptr} {
-		clear();
-		for(int k = 0; k < l.size(); k += 4) {
-			(*this) += region_t(l[k], l[k+1], l[k+2], l[k+3]);
+		vector<i_rect_t<int>> rects;
+		rects.reserve(l.size() / 4);
+		for(size_t k = 0; k + 3 < l.size(); k += 4) {
+			rects.push_back(i_rect_t<int>(l[k], l[k+1], l[k+2], l[k+3]));
 		}
+		clear();
+		(*this) = from_rects(rects);
 	}
 
 	region_t(region_t const & b) {
@@ -560,6 +636,11 @@ public:
 		}
 	}
 
+	region_t const & operator =(region_t && b) {
+		std::swap(_data, b._data);
+		return *this;
+	}
+
 	region_t const & operator =(region_t const & b) {
 		if(this != &b) {
 			if(_data != nullptr)
@@ -570,6 +651,118 @@ public:
 		return *this;
 	}
 
+	/**
+	 * Build the union of rects with a single sort-and-sweep, much cheaper
+	 * than adding them one by one.
+	 **/
+	static region_t from_rects(vector<i_rect_t<int>> const & rects) {
+		return from_rects(rects.data(), rects.size());
+	}
+
+	static region_t from_rects(i_rect_t<int> const * rects, int count) {
+		auto & arena = _arena();
+		auto & data = arena.data;
+		auto & edges = arena.edges;
+		auto & sorted = arena.rects;
+		auto & active = arena.active;
+		auto & spans = arena.spans;
+
+		sorted.clear();
+		edges.clear();
+		for(int k = 0; k < count; ++k) {
+			if(rects[k].w <= 0 or rects[k].h <= 0)
+				continue;
+			sorted.push_back(rects[k]);
+			edges.push_back(rects[k].y);
+			edges.push_back(rects[k].y + rects[k].h);
+		}
+
+		region_t r;
+		if(sorted.empty())
+			return r;
+
+		std::sort(sorted.begin(), sorted.end(),
+				[](i_rect_t<int> const & a, i_rect_t<int> const & b) { return a.y < b.y; });
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		/* header, see _data layout, offsets are used since data may grow */
+		data.resize(3);
+		data[0] = 0;
+		data[1] = 0;
+		data[2] = 0;
+		int prev_band = -1;
+
+		active.clear();
+		auto next = sorted.begin();
+		for(size_t e = 0; e + 1 < edges.size(); ++e) {
+			int start = edges[e];
+			int end = edges[e + 1];
+
+			active.erase(std::remove_if(active.begin(), active.end(),
+					[start](i_rect_t<int> const & x) { return x.y + x.h <= start; }),
+					active.end());
+			while(next != sorted.end() and next->y <= start) {
+				active.push_back(*next);
+				++next;
+			}
+
+			if(active.empty())
+				continue;
+
+			spans.clear();
+			for(auto const & x: active)
+				spans.push_back(make_pair(x.x, x.x + x.w));
+			std::sort(spans.begin(), spans.end());
+
+			/* merge overlapping spans in place */
+			int n = 0;
+			for(auto const & s: spans) {
+				if(n > 0 and s.first <= spans[n - 1].second) {
+					spans[n - 1].second = std::max(spans[n - 1].second, s.second);
+				} else {
+					spans[n++] = s;
+				}
+			}
+
+			/* extend the previous band if both are the same */
+			if(prev_band >= 0 and data[prev_band + 3] == start
+					and data[prev_band + 1] == 2 * n) {
+				bool same = true;
+				for(int k = 0; k < n and same; ++k) {
+					same = data[prev_band + 4 + 2 * k] == spans[k].first
+						and data[prev_band + 5 + 2 * k] == spans[k].second;
+				}
+				if(same) {
+					data[prev_band + 3] = end;
+					continue;
+				}
+			}
+
+			int band = data.size();
+			if(prev_band >= 0)
+				data[prev_band] = band;
+			else
+				data[2] = band;
+
+			data.push_back(0);
+			data.push_back(2 * n);
+			data.push_back(start);
+			data.push_back(end);
+			for(int k = 0; k < n; ++k) {
+				data.push_back(spans[k].first);
+				data.push_back(spans[k].second);
+			}
+
+			prev_band = band;
+			data[0] += 1;
+			data[1] += 2 * n;
+		}
+
+		r._assign_data(data.data(), data.size());
+		return r;
+	}
+
 	region_t operator +(region_t const & b) const {
 		return _merge(&_operator_union, *this, b);
 	}
@@ -7,6 +7,8 @@
  *
  */
 
+#include <sys/stat.h>
+
 #include <cairo-xcb.h>
 #include <string>
 #include <algorithm>
@@ -78,6 +80,7 @@ rect simple2_theme_t::compute_notebook_menu_position(
 simple2_theme_t::simple2_theme_t(config_handler_t & conf)
 {
 	backgroun_px = nullptr;
+	_background_cancellable = g_cancellable_new();
 
 	notebook.margin.top = 4;
 	notebook.margin.bottom = 4;
@@ -393,11 +396,85 @@ simple2_theme_t::~simple2_theme_t() {
 	pango_font_description_free(floating_normal_font);
 	pango_font_description_free(pango_popup_font);
 
+	_layout_cache.clear();
+
+	/* pending decodes must not call back this theme */
+	g_cancellable_cancel(_background_cancellable);
+	g_object_unref(_background_cancellable);
+	if (backgroun_px != nullptr)
+		cairo_surface_destroy(backgroun_px);
+	for (auto & x: _background_cache)
+		cairo_surface_destroy(x.second);
+
 	g_object_unref(pango_context);
 	g_object_unref(pango_font_map);
 
 }
 
+size_t pango_layout_cache_t::key_hash_t::operator()(key_t const & k) const
+{
+	size_t h = std::hash<std::string>{}(k.text);
+	h = h * 31 + std::hash<void const *>{}(k.font);
+	h = h * 31 + std::hash<int>{}(k.width);
+	h = h * 31 + std::hash<int>{}(k.ellipsize);
+	h = h * 31 + std::hash<int>{}(k.alignment);
+	return h;
+}
+
+pango_layout_cache_t::~pango_layout_cache_t()
+{
+	clear();
+}
+
+auto pango_layout_cache_t::get(PangoContext * context, std::string const & text,
+		PangoFontDescription const * font, int width,
+		PangoEllipsizeMode ellipsize, PangoAlignment alignment) -> PangoLayout *
+{
+	key_t key{text, font, width, ellipsize, alignment};
+	auto x = _index.find(key);
+	if (x != _index.end()) {
+		_entries.splice(_entries.begin(), _entries, x->second);
+		return x->second->second;
+	}
+
+	PangoLayout * layout = pango_layout_new(context);
+	pango_layout_set_font_description(layout, font);
+	pango_layout_set_text(layout, text.c_str(), -1);
+	pango_layout_set_width(layout, width * PANGO_SCALE);
+	pango_layout_set_wrap(layout, PANGO_WRAP_CHAR);
+	pango_layout_set_ellipsize(layout, ellipsize);
+	pango_layout_set_alignment(layout, alignment);
+
+	if (_entries.size() >= capacity) {
+		g_object_unref(_entries.back().second);
+		_index.erase(_entries.back().first);
+		_entries.pop_back();
+	}
+
+	_entries.emplace_front(key, layout);
+	_index[key] = _entries.begin();
+	return layout;
+}
+
+void pango_layout_cache_t::clear()
+{
+	for (auto & x: _entries)
+		g_object_unref(x.second);
+	_entries.clear();
+	_index.clear();
+}
+
+void simple2_theme_t::_layout_path(cairo_t * cr, std::string const & text,
+		PangoFontDescription const * font, int width,
+		PangoEllipsizeMode ellipsize, PangoAlignment alignment) const
+{
+	auto layout = _layout_cache.get(pango_context, text, font, width,
+			ellipsize, alignment);
+	/* only re-layout if the cairo font options or matrix changed */
+	pango_cairo_update_layout(cr, layout);
+	pango_cairo_layout_path(cr, layout);
+}
+
 void simple2_theme_t::rounded_i_rect(cairo_t * cr, double x, double y,
 		double w, double h, double r) {
 
@@ -512,16 +589,8 @@ void simple2_theme_t::render_notebook(cairo_t * cr, theme_notebook_t const * n)
 		CHECK_CAIRO(cairo_set_line_join(cr, CAIRO_LINE_JOIN_BEVEL));
 
 		{
-			PangoLayout * pango_layout = pango_layout_new(pango_context);
-			pango_layout_set_font_description(pango_layout,
-					notebook_selected_font);
-			pango_cairo_update_layout(cr, pango_layout);
-			pango_layout_set_text(pango_layout, buf, -1);
-			pango_layout_set_width(pango_layout, btext.w * PANGO_SCALE);
-			pango_layout_set_wrap(pango_layout, PANGO_WRAP_CHAR);
-			pango_layout_set_ellipsize(pango_layout, PANGO_ELLIPSIZE_END);
-			pango_cairo_layout_path(cr, pango_layout);
-			g_object_unref(pango_layout);
+			_layout_path(cr, buf, notebook_selected_font, btext.w,
+					PANGO_ELLIPSIZE_END, PANGO_ALIGN_LEFT);
 		}
 
 		CHECK_CAIRO(cairo_stroke_preserve(cr));
@@ -804,15 +873,8 @@ void simple2_theme_t::render_notebook_selected(
 
 		{
 			cairo_new_path(cr);
-			PangoLayout * pango_layout = pango_layout_new(pango_context);
-			pango_layout_set_font_description(pango_layout, pango_font);
-			pango_cairo_update_layout(cr, pango_layout);
-			pango_layout_set_text(pango_layout, data.title.c_str(), -1);
-			pango_layout_set_wrap(pango_layout, PANGO_WRAP_CHAR);
-			pango_layout_set_ellipsize(pango_layout, PANGO_ELLIPSIZE_END);
-			pango_layout_set_width(pango_layout, btext.w * PANGO_SCALE);
-			pango_cairo_layout_path(cr, pango_layout);
-			g_object_unref(pango_layout);
+			_layout_path(cr, data.title, pango_font, btext.w,
+					PANGO_ELLIPSIZE_END, PANGO_ALIGN_LEFT);
 		}
 
 		CHECK_CAIRO(cairo_set_line_width(cr, 3.0));
@@ -962,15 +1024,8 @@ void simple2_theme_t::render_notebook_normal(
 		CHECK_CAIRO(cairo_set_line_join(cr, CAIRO_LINE_JOIN_BEVEL));
 
 		{
-			PangoLayout * pango_layout = pango_layout_new(pango_context);
-			pango_layout_set_font_description(pango_layout, pango_font);
-			pango_cairo_update_layout(cr, pango_layout);
-			pango_layout_set_text(pango_layout, data.title.c_str(), -1);
-			pango_layout_set_width(pango_layout, btext.w * PANGO_SCALE);
-			pango_layout_set_wrap(pango_layout, PANGO_WRAP_CHAR);
-			pango_layout_set_ellipsize(pango_layout, PANGO_ELLIPSIZE_END);
-			pango_cairo_layout_path(cr, pango_layout);
-			g_object_unref(pango_layout);
+			_layout_path(cr, data.title, pango_font, btext.w,
+					PANGO_ELLIPSIZE_END, PANGO_ALIGN_LEFT);
 		}
 
 		CHECK_CAIRO(cairo_stroke_preserve(cr));
@@ -1153,16 +1208,8 @@ void simple2_theme_t::render_thumbnail_title(cairo_t * cr, rect btext, std::stri
 	CHECK_CAIRO(cairo_set_line_join(cr, CAIRO_LINE_JOIN_BEVEL));
 
 	{
-		PangoLayout * pango_layout = pango_layout_new(pango_context);
-		pango_layout_set_font_description(pango_layout, notebook_normal_font);
-		pango_cairo_update_layout(cr, pango_layout);
-		pango_layout_set_text(pango_layout, title.c_str(), -1);
-		pango_layout_set_width(pango_layout, btext.w * PANGO_SCALE);
-		pango_layout_set_wrap(pango_layout, PANGO_WRAP_CHAR);
-		pango_layout_set_ellipsize(pango_layout, PANGO_ELLIPSIZE_MIDDLE);
-		pango_layout_set_alignment(pango_layout, PANGO_ALIGN_CENTER);
-		pango_cairo_layout_path(cr, pango_layout);
-		g_object_unref(pango_layout);
+		_layout_path(cr, title, notebook_normal_font, btext.w,
+				PANGO_ELLIPSIZE_MIDDLE, PANGO_ALIGN_CENTER);
 	}
 
 	CHECK_CAIRO(cairo_stroke_preserve(cr));
@@ -1313,15 +1360,8 @@ void simple2_theme_t::render_floating_base(
 		{
 
 			{
-				PangoLayout * pango_layout = pango_layout_new(pango_context);
-				pango_layout_set_font_description(pango_layout, pango_font);
-				pango_cairo_update_layout(cr, pango_layout);
-				pango_layout_set_text(pango_layout, mw->title.c_str(), -1);
-				pango_layout_set_wrap(pango_layout, PANGO_WRAP_CHAR);
-				pango_layout_set_ellipsize(pango_layout, PANGO_ELLIPSIZE_END);
-				pango_layout_set_width(pango_layout, btext.w * PANGO_SCALE);
-				pango_cairo_layout_path(cr, pango_layout);
-				g_object_unref(pango_layout);
+				_layout_path(cr, mw->title, pango_font, btext.w,
+						PANGO_ELLIPSIZE_END, PANGO_ALIGN_LEFT);
 			}
 
 			CHECK_CAIRO(cairo_set_line_width(cr, 3.0));
@@ -1474,15 +1514,8 @@ void simple2_theme_t::render_popup_notebook0(cairo_t * cr, icon64 * icon, unsign
 		CHECK_CAIRO(cairo_translate(cr, 0.0, y_offset + 68.0));
 
 		{
-			PangoLayout * pango_layout = pango_layout_new(pango_context);
-			pango_layout_set_font_description(pango_layout, pango_popup_font);
-			pango_cairo_update_layout(cr, pango_layout);
-			pango_layout_set_text(pango_layout, title.c_str(), -1);
-			pango_layout_set_width(pango_layout, width * PANGO_SCALE);
-			pango_layout_set_alignment(pango_layout, PANGO_ALIGN_CENTER);
-			pango_layout_set_wrap(pango_layout, PANGO_WRAP_CHAR);
-			pango_cairo_layout_path(cr, pango_layout);
-			g_object_unref(pango_layout);
+			_layout_path(cr, title, pango_popup_font, width,
+					PANGO_ELLIPSIZE_NONE, PANGO_ALIGN_CENTER);
 		}
 
 		CHECK_CAIRO(cairo_set_line_width(cr, 5.0));
@@ -1560,196 +1593,279 @@ void simple2_theme_t::draw_hatched_i_rect(cairo_t * cr, int space, int x, int y,
 }
 
 void simple2_theme_t::update(int width, int height) {
+	_layout_cache.clear();
 	create_background_img(width, height);
 }
 
-void simple2_theme_t::create_background_img(int width, int height) {
+/**
+ * Decode and scale the background, it is run in a worker thread thus it
+ * must not access the theme.
+ **/
+static auto create_scaled_background(std::string const & background_file,
+		std::string const & scale_mode, int width, int height) -> cairo_surface_t *
+{
+	cairo_surface_t * tmp = cairo_image_surface_create_from_png(
+			background_file.c_str());
 
-	if(backgroun_px) {
-		cairo_surface_destroy(backgroun_px);
-		backgroun_px = nullptr;
-	}
+	cairo_surface_t * image_background_s = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
 
-	if (has_background) {
-		if(not exists(background_file.c_str()))
-			throw wrong_config_file_t("background file not found!");
+	/**
+	 * WARNING: transform order and set_source_surface have huge
+	 * Consequence.
+	 **/
 
-		cairo_surface_t * tmp = cairo_image_surface_create_from_png(
-				background_file.c_str());
+	double src_width = cairo_image_surface_get_width(tmp);
+	double src_height = cairo_image_surface_get_height(tmp);
 
-		cairo_surface_t * image_background_s = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+	if (src_width > 0 and src_height > 0) {
 
-		/**
-		 * WARNING: transform order and set_source_surface have huge
-		 * Consequence.
-		 **/
+		if (scale_mode == "stretch") {
 
-		double src_width = cairo_image_surface_get_width(tmp);
-		double src_height = cairo_image_surface_get_height(tmp);
+			cairo_t * cr = cairo_create(image_background_s);
 
-		if (src_width > 0 and src_height > 0) {
+			CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
+			CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
+			CHECK_CAIRO(cairo_fill(cr));
 
-			if (scale_mode == "stretch") {
+			double x_ratio = width / src_width;
+			double y_ratio = height / src_height;
+			CHECK_CAIRO(cairo_scale(cr, x_ratio, y_ratio));
+			CHECK_CAIRO(cairo_set_source_surface(cr, tmp, 0, 0));
+			CHECK_CAIRO(cairo_rectangle(cr, 0, 0, src_width, src_height));
+			CHECK_CAIRO(cairo_fill(cr));
 
-				cairo_t * cr = cairo_create(image_background_s);
+			warn(cairo_get_reference_count(cr) == 1);
+			cairo_destroy(cr);
 
-				CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
-				CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
-				CHECK_CAIRO(cairo_fill(cr));
+		} else if (scale_mode == "zoom") {
+
+			cairo_t * cr = cairo_create(image_background_s);
+
+			CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
+			CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
+			CHECK_CAIRO(cairo_fill(cr));
 
-				double x_ratio = width / src_width;
-				double y_ratio = height / src_height;
-				CHECK_CAIRO(cairo_scale(cr, x_ratio, y_ratio));
-				CHECK_CAIRO(cairo_set_source_surface(cr, tmp, 0, 0));
-				CHECK_CAIRO(cairo_rectangle(cr, 0, 0, src_width, src_height));
+			double x_ratio = width / (double)src_width;
+			double y_ratio = height / (double)src_height;
+
+			double x_offset;
+			double y_offset;
+
+			if (x_ratio > y_ratio) {
+
+				double yp = height / x_ratio;
+
+				x_offset = 0;
+				y_offset = (yp - src_height) / 2.0;
+
+				CHECK_CAIRO(cairo_scale(cr, x_ratio, x_ratio));
+				CHECK_CAIRO(cairo_set_source_surface(cr, tmp, x_offset, y_offset));
+				CHECK_CAIRO(cairo_rectangle(cr, 0, 0, src_width, yp));
 				CHECK_CAIRO(cairo_fill(cr));
 
-				warn(cairo_get_reference_count(cr) == 1);
-				cairo_destroy(cr);
+			} else {
 
-			} else if (scale_mode == "zoom") {
+				double xp = width / y_ratio;
 
-				cairo_t * cr = cairo_create(image_background_s);
+				x_offset = (xp - src_width) / 2.0;
+				y_offset = 0;
 
-				CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
-				CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
+				CHECK_CAIRO(cairo_scale(cr, y_ratio, y_ratio));
+				CHECK_CAIRO(cairo_set_source_surface(cr, tmp, x_offset, y_offset));
+				CHECK_CAIRO(cairo_rectangle(cr, 0, 0, xp, src_height));
 				CHECK_CAIRO(cairo_fill(cr));
+			}
 
-				double x_ratio = width / (double)src_width;
-				double y_ratio = height / (double)src_height;
+			warn(cairo_get_reference_count(cr) == 1);
+			cairo_destroy(cr);
 
-				double x_offset;
-				double y_offset;
+		} else if (scale_mode == "center") {
 
-				if (x_ratio > y_ratio) {
+			cairo_t * cr = cairo_create(image_background_s);
 
-					double yp = height / x_ratio;
+			CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
+			CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
+			CHECK_CAIRO(cairo_fill(cr));
 
-					x_offset = 0;
-					y_offset = (yp - src_height) / 2.0;
+			double x_offset = (width - src_width) / 2.0;
+			double y_offset = (height - src_height) / 2.0;
 
-					CHECK_CAIRO(cairo_scale(cr, x_ratio, x_ratio));
-					CHECK_CAIRO(cairo_set_source_surface(cr, tmp, x_offset, y_offset));
-					CHECK_CAIRO(cairo_rectangle(cr, 0, 0, src_width, yp));
-					CHECK_CAIRO(cairo_fill(cr));
+			CHECK_CAIRO(cairo_set_source_surface(cr, tmp, x_offset, y_offset));
+			CHECK_CAIRO(cairo_rectangle(cr, max<double>(0.0, x_offset),
+					max<double>(0.0, y_offset),
+					min<double>(src_width, width),
+					min<double>(src_height, height)));
+			CHECK_CAIRO(cairo_fill(cr));
 
-				} else {
+			warn(cairo_get_reference_count(cr) == 1);
+			cairo_destroy(cr);
 
-					double xp = width / y_ratio;
+		} else if (scale_mode == "scale" || scale_mode == "span") {
 
-					x_offset = (xp - src_width) / 2.0;
-					y_offset = 0;
+			cairo_t * cr = cairo_create(image_background_s);
 
-					CHECK_CAIRO(cairo_scale(cr, y_ratio, y_ratio));
-					CHECK_CAIRO(cairo_set_source_surface(cr, tmp, x_offset, y_offset));
-					CHECK_CAIRO(cairo_rectangle(cr, 0, 0, xp, src_height));
-					CHECK_CAIRO(cairo_fill(cr));
-				}
+			CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
+			CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
+			CHECK_CAIRO(cairo_fill(cr));
 
-				warn(cairo_get_reference_count(cr) == 1);
-				cairo_destroy(cr);
+			double x_ratio = width / src_width;
+			double y_ratio = height / src_height;
 
-			} else if (scale_mode == "center") {
+			double x_offset, y_offset;
 
-				cairo_t * cr = cairo_create(image_background_s);
+			if (x_ratio < y_ratio) {
 
-				CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
-				CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
-				CHECK_CAIRO(cairo_fill(cr));
+				double yp = height / x_ratio;
 
-				double x_offset = (width - src_width) / 2.0;
-				double y_offset = (height - src_height) / 2.0;
+				x_offset = 0;
+				y_offset = (yp - src_height) / 2.0;
 
+				CHECK_CAIRO(cairo_scale(cr, x_ratio, x_ratio));
 				CHECK_CAIRO(cairo_set_source_surface(cr, tmp, x_offset, y_offset));
-				CHECK_CAIRO(cairo_rectangle(cr, max<double>(0.0, x_offset),
-						max<double>(0.0, y_offset),
-						min<double>(src_width, width),
-						min<double>(src_height, height)));
+				CHECK_CAIRO(cairo_rectangle(cr, x_offset, y_offset, src_width, src_height));
 				CHECK_CAIRO(cairo_fill(cr));
 
-				warn(cairo_get_reference_count(cr) == 1);
-				cairo_destroy(cr);
+			} else {
+				double xp = width / y_ratio;
 
-			} else if (scale_mode == "scale" || scale_mode == "span") {
+				y_offset = 0;
+				x_offset = (xp - src_width) / 2.0;
 
-				cairo_t * cr = cairo_create(image_background_s);
-
-				CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
-				CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
+				CHECK_CAIRO(cairo_scale(cr, y_ratio, y_ratio));
+				CHECK_CAIRO(cairo_set_source_surface(cr, tmp, x_offset, y_offset));
+				CHECK_CAIRO(cairo_rectangle(cr, x_offset, y_offset, src_width, src_height));
 				CHECK_CAIRO(cairo_fill(cr));
+			}
 
-				double x_ratio = width / src_width;
-				double y_ratio = height / src_height;
+			warn(cairo_get_reference_count(cr) == 1);
+			cairo_destroy(cr);
 
-				double x_offset, y_offset;
+		} else if (scale_mode == "tile") {
 
-				if (x_ratio < y_ratio) {
+			cairo_t * cr = cairo_create(image_background_s);
+			CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
+			CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
+			CHECK_CAIRO(cairo_fill(cr));
 
-					double yp = height / x_ratio;
+			for (double x = 0; x < width; x += src_width) {
+				for (double y = 0; y < height; y += src_height) {
+					CHECK_CAIRO(cairo_identity_matrix(cr));
+					CHECK_CAIRO(cairo_translate(cr, x, y));
+					CHECK_CAIRO(cairo_set_source_surface(cr, tmp, 0, 0));
+					CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
+					CHECK_CAIRO(cairo_fill(cr));
+				}
+			}
 
-					x_offset = 0;
-					y_offset = (yp - src_height) / 2.0;
+			warn(cairo_get_reference_count(cr) == 1);
+			cairo_destroy(cr);
 
-					CHECK_CAIRO(cairo_scale(cr, x_ratio, x_ratio));
-					CHECK_CAIRO(cairo_set_source_surface(cr, tmp, x_offset, y_offset));
-					CHECK_CAIRO(cairo_rectangle(cr, x_offset, y_offset, src_width, src_height));
-					CHECK_CAIRO(cairo_fill(cr));
+		}
 
-				} else {
-					double xp = width / y_ratio;
+	}
 
-					y_offset = 0;
-					x_offset = (xp - src_width) / 2.0;
+	warn(cairo_surface_get_reference_count(tmp) == 1);
+	cairo_surface_destroy(tmp);
 
-					CHECK_CAIRO(cairo_scale(cr, y_ratio, y_ratio));
-					CHECK_CAIRO(cairo_set_source_surface(cr, tmp, x_offset, y_offset));
-					CHECK_CAIRO(cairo_rectangle(cr, x_offset, y_offset, src_width, src_height));
-					CHECK_CAIRO(cairo_fill(cr));
-				}
+	return image_background_s;
+}
 
-				warn(cairo_get_reference_count(cr) == 1);
-				cairo_destroy(cr);
 
-			} else if (scale_mode == "tile") {
+void simple2_theme_t::create_background_img(int width, int height) {
+	if (not has_background)
+		return;
 
-				cairo_t * cr = cairo_create(image_background_s);
-				CHECK_CAIRO(::cairo_set_source_rgb(cr, 0.5, 0.5, 0.5));
-				CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
-				CHECK_CAIRO(cairo_fill(cr));
+	struct stat st;
+	if (stat(background_file.c_str(), &st) != 0)
+		throw wrong_config_file_t("background file not found!");
 
-				for (double x = 0; x < width; x += src_width) {
-					for (double y = 0; y < height; y += src_height) {
-						CHECK_CAIRO(cairo_identity_matrix(cr));
-						CHECK_CAIRO(cairo_translate(cr, x, y));
-						CHECK_CAIRO(cairo_set_source_surface(cr, tmp, 0, 0));
-						CHECK_CAIRO(cairo_rectangle(cr, 0, 0, width, height));
-						CHECK_CAIRO(cairo_fill(cr));
-					}
-				}
+	background_key_t key{st.st_mtime, scale_mode, width, height};
+	_background_wanted = key;
 
-				warn(cairo_get_reference_count(cr) == 1);
-				cairo_destroy(cr);
+	auto x = _background_cache.find(key);
+	if (x != _background_cache.end()) {
+		_set_background(x->second);
+		return;
+	}
 
-			}
+	/* keep the current background until the new one is ready */
+	if (_background_pending.count(key))
+		return;
+	_background_pending.insert(key);
+
+	auto task = g_task_new(nullptr, _background_cancellable,
+			&simple2_theme_t::_background_ready, this);
+	g_task_set_task_data(task, new background_request_t{background_file, key},
+			[](gpointer data) { delete reinterpret_cast<background_request_t *>(data); });
+	g_task_run_in_thread(task, &simple2_theme_t::_background_task);
+	g_object_unref(task);
+}
 
-		}
+void simple2_theme_t::_set_background(cairo_surface_t * s)
+{
+	if (backgroun_px != nullptr)
+		cairo_surface_destroy(backgroun_px);
+	backgroun_px = cairo_surface_reference(s);
+}
 
-		warn(cairo_surface_get_reference_count(tmp) == 1);
-		cairo_surface_destroy(tmp);
+void simple2_theme_t::_background_task(GTask * task, gpointer source,
+		gpointer task_data, GCancellable * cancellable)
+{
+	auto req = reinterpret_cast<background_request_t *>(task_data);
+	auto surface = create_scaled_background(req->file, std::get<1>(req->key),
+			std::get<2>(req->key), std::get<3>(req->key));
+	g_task_return_pointer(task, surface,
+			reinterpret_cast<GDestroyNotify>(&cairo_surface_destroy));
+}
 
-		/* copy background to pixmap */
-		backgroun_px = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+void simple2_theme_t::_background_ready(GObject * source, GAsyncResult * res,
+		gpointer user_data)
+{
+	auto task = G_TASK(res);
 
-		cairo_t * cr = cairo_create(backgroun_px);
-		cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
-		cairo_set_source_surface(cr, image_background_s, 0.0, 0.0);
-		cairo_paint(cr);
-		cairo_destroy(cr);
+	/* the theme is already destroyed */
+	if (g_cancellable_is_cancelled(g_task_get_cancellable(task)))
+		return;
+
+	auto ths = reinterpret_cast<simple2_theme_t *>(user_data);
+	auto req = reinterpret_cast<background_request_t *>(g_task_get_task_data(task));
+	auto surface = reinterpret_cast<cairo_surface_t *>(g_task_propagate_pointer(task, nullptr));
 
-		cairo_surface_destroy(image_background_s);
+	ths->_background_pending.erase(req->key);
+	if (surface == nullptr)
+		return;
+
+	/* drop backgrounds of a previous version of the file */
+	for (auto i = ths->_background_cache.begin(); i != ths->_background_cache.end();) {
+		if (std::get<0>(i->first) != std::get<0>(req->key)) {
+			cairo_surface_destroy(i->second);
+			i = ths->_background_cache.erase(i);
+		} else {
+			++i;
+		}
+	}
 
+	auto old = ths->_background_cache.find(req->key);
+	if (old != ths->_background_cache.end())
+		cairo_surface_destroy(old->second);
+	ths->_background_cache[req->key] = surface;
+
+	/* evict other sizes, backgroun_px hold its own reference */
+	for (auto i = ths->_background_cache.begin();
+			i != ths->_background_cache.end()
+			and ths->_background_cache.size() > background_cache_size;) {
+		if (i->first != req->key and i->first != ths->_background_wanted) {
+			cairo_surface_destroy(i->second);
+			i = ths->_background_cache.erase(i);
+		} else {
+			++i;
+		}
 	}
 
+	if (req->key == ths->_background_wanted) {
+		ths->_set_background(surface);
+		ths->on_background_change.signal(ths);
+	}
 }
 
 void simple2_theme_t::render_popup_split(cairo_t * cr, theme_split_t const * s,
@@ -1861,15 +1977,8 @@ void simple2_theme_t::render_menuentry(cairo_t * cr, theme_dropdown_menu_entry_t
 	{
 
 		{
-			PangoLayout * pango_layout = pango_layout_new(pango_context);
-			pango_layout_set_font_description(pango_layout, notebook_normal_font);
-			pango_cairo_update_layout(cr, pango_layout);
-			pango_layout_set_text(pango_layout, item.label.c_str(), -1);
-			pango_layout_set_wrap(pango_layout, PANGO_WRAP_CHAR);
-			pango_layout_set_ellipsize(pango_layout, PANGO_ELLIPSIZE_END);
-			pango_layout_set_width(pango_layout, btext.w * PANGO_SCALE);
-			pango_cairo_layout_path(cr, pango_layout);
-			g_object_unref(pango_layout);
+			_layout_path(cr, item.label, notebook_normal_font, btext.w,
+					PANGO_ELLIPSIZE_END, PANGO_ALIGN_LEFT);
 		}
 
 		CHECK_CAIRO(cairo_set_line_width(cr, 3.0));
@@ -1926,16 +2035,8 @@ auto simple2_theme_t::workspace_switch_popup(string const & workspace_name) cons
 	{
 
 		{
-			PangoLayout * pango_layout = pango_layout_new(pango_context);
-			pango_layout_set_font_description(pango_layout, pango_popup_font);
-			pango_cairo_update_layout(cr, pango_layout);
-			pango_layout_set_text(pango_layout, workspace_name.c_str(), -1);
-			pango_layout_set_wrap(pango_layout, PANGO_WRAP_CHAR);
-			pango_layout_set_ellipsize(pango_layout, PANGO_ELLIPSIZE_END);
-			pango_layout_set_width(pango_layout, 596 * PANGO_SCALE);
-			pango_layout_set_alignment(pango_layout, PANGO_ALIGN_CENTER);
-			pango_cairo_layout_path(cr, pango_layout);
-			g_object_unref(pango_layout);
+			_layout_path(cr, workspace_name, pango_popup_font, 596,
+					PANGO_ELLIPSIZE_END, PANGO_ALIGN_CENTER);
 		}
 		cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 		CHECK_CAIRO(cairo_set_line_width(cr, 12.0));
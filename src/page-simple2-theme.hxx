@@ -12,6 +12,13 @@
 
 #include <pango/pangocairo.h>
 #include <memory>
+#include <list>
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+#include <gio/gio.h>
 
 #include <cairo.h>
 #include <cairo-xlib.h>
@@ -23,6 +30,52 @@
 
 namespace page {
 
+/**
+ * LRU cache of shaped pango layouts, shaping titles is the most expensive
+ * part of tabs rendering. Colors are not part of the key, they are applied
+ * when the layout path is stroked and filled.
+ **/
+class pango_layout_cache_t {
+	struct key_t {
+		std::string text;
+		PangoFontDescription const * font;
+		int width;
+		PangoEllipsizeMode ellipsize;
+		PangoAlignment alignment;
+
+		bool operator==(key_t const & x) const {
+			return font == x.font and width == x.width
+					and ellipsize == x.ellipsize
+					and alignment == x.alignment and text == x.text;
+		}
+	};
+
+	struct key_hash_t {
+		size_t operator()(key_t const & k) const;
+	};
+
+	using entry_t = std::pair<key_t, PangoLayout *>;
+
+	static size_t const capacity = 512;
+
+	/* most recently used first */
+	std::list<entry_t> _entries;
+	std::unordered_map<key_t, std::list<entry_t>::iterator, key_hash_t> _index;
+
+public:
+	pango_layout_cache_t() { }
+	~pango_layout_cache_t();
+
+	pango_layout_cache_t(pango_layout_cache_t const &) = delete;
+	pango_layout_cache_t & operator=(pango_layout_cache_t const &) = delete;
+
+	auto get(PangoContext * context, std::string const & text,
+			PangoFontDescription const * font, int width,
+			PangoEllipsizeMode ellipsize, PangoAlignment alignment) -> PangoLayout *;
+	void clear();
+
+};
+
 class simple2_theme_t : public theme_t {
 public:
 
@@ -51,6 +104,13 @@ public:
 	PangoFontMap * pango_font_map;
 	PangoContext * pango_context;
 
+	mutable pango_layout_cache_t _layout_cache;
+
+	/* add the path of text to cr, using a cached layout */
+	void _layout_path(cairo_t * cr, std::string const & text,
+			PangoFontDescription const * font, int width,
+			PangoEllipsizeMode ellipsize, PangoAlignment alignment) const;
+
 
 	cairo_surface_t * vsplit_button_s;
 	cairo_surface_t * hsplit_button_s;
@@ -115,6 +175,28 @@ public:
 
 	cairo_surface_t * backgroun_px;
 
+	/** scaled backgrounds by (file mtime, scale mode, width, height) **/
+	using background_key_t = std::tuple<time_t, std::string, int, int>;
+
+	struct background_request_t {
+		std::string file;
+		background_key_t key;
+	};
+
+	/** max scaled backgrounds kept, e.g. before and after a screen resize **/
+	static unsigned const background_cache_size = 2;
+
+	std::map<background_key_t, cairo_surface_t *> _background_cache;
+	std::set<background_key_t> _background_pending;
+	background_key_t _background_wanted;
+	GCancellable * _background_cancellable;
+
+	void _set_background(cairo_surface_t * s);
+	static void _background_task(GTask * task, gpointer source,
+			gpointer task_data, GCancellable * cancellable);
+	static void _background_ready(GObject * source, GAsyncResult * res,
+			gpointer user_data);
+
 	simple2_theme_t(config_handler_t & conf);
 
 	virtual ~simple2_theme_t();
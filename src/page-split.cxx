@@ -14,6 +14,7 @@
 
 #include "page-page.hxx"
 #include "page-split.hxx"
+#include "page-layout.hxx"
 #include "page-grab-handlers.hxx"
 #include "page-workspace.hxx"
 
@@ -60,7 +61,7 @@ void split_t::set_split(double split) {
 	if(split > 0.95)
 		split = 0.95;
 	_ratio = split;
-	update_allocation();
+	update_allocation(true);
 }
 
 void split_t::compute_children_allocation(double split, rect & bpack0, rect & bpack1) {
@@ -73,94 +74,44 @@ void split_t::compute_children_allocation(double split, rect & bpack0, rect & bp
 	if(_pack1 != nullptr)
 		_pack1->get_min_allocation(pack1_width, pack1_height);
 
-	//cout << "pack0 = " << pack0_width << "," << pack0_height << endl;
-	//cout << "pack1 = " << pack1_width << "," << pack1_height << endl;
-
-	if (_type == VERTICAL_SPLIT) {
-
-		int w = allocation().w
-				- 2 * _ctx->theme()->split.margin.left
-				- 2 * _ctx->theme()->split.margin.right
-				- _ctx->theme()->split.width;
-
-		int w0 = floor(w * split + 0.5);
-		int w1 = w - w0;
-
-
-		if(w0 < pack0_width) {
-			w1 -= pack0_width - w0;
-			w0 = pack0_width;
-		}
-
-		if(w1 < pack1_width) {
-			w0 -= pack1_width - w1;
-			w1 = pack1_width;
-		}
-
-		bpack0.x = allocation().x + _ctx->theme()->split.margin.left;
-		bpack0.y = allocation().y + _ctx->theme()->split.margin.top;
-		bpack0.w = w0;
-		bpack0.h = allocation().h - _ctx->theme()->split.margin.top - _ctx->theme()->split.margin.bottom;
-
-		bpack1.x = allocation().x + _ctx->theme()->split.margin.left + w0 + _ctx->theme()->split.margin.right + _ctx->theme()->split.width + _ctx->theme()->split.margin.left;
-		bpack1.y = allocation().y + _ctx->theme()->split.margin.top;
-		bpack1.w = w1;
-		bpack1.h = allocation().h - _ctx->theme()->split.margin.top - _ctx->theme()->split.margin.bottom;
-
-		if(_parent != nullptr) {
-			assert(bpack0.w >= pack0_width);
-			assert(bpack0.h >= pack0_height);
-			assert(bpack1.w >= pack1_width);
-			assert(bpack1.h >= pack1_height);
-		}
-
-	} else {
-
-		int h = allocation().h - 2 * _ctx->theme()->split.margin.top - 2 * _ctx->theme()->split.margin.bottom - _ctx->theme()->split.width;
-		int h0 = floor(h * split + 0.5);
-		int h1 = h - h0;
-
-		if(h0 < pack0_height) {
-			h1 -= pack0_height - h0;
-			h0 = pack0_height;
-		}
-
-		if(h1 < pack1_height) {
-			h0 -= pack1_height - h1;
-			h1 = pack1_height;
-		}
-
-		bpack0.x = allocation().x + _ctx->theme()->split.margin.left;
-		bpack0.y = allocation().y + _ctx->theme()->split.margin.top;
-		bpack0.w = allocation().w - _ctx->theme()->split.margin.left - _ctx->theme()->split.margin.right;
-		bpack0.h = h0;
-
-		bpack1.x = allocation().x + _ctx->theme()->split.margin.left;
-		bpack1.y = allocation().y + _ctx->theme()->split.margin.top + h0 + _ctx->theme()->split.margin.bottom + _ctx->theme()->split.width + _ctx->theme()->split.margin.top;
-		bpack1.w = allocation().w - _ctx->theme()->split.margin.left - _ctx->theme()->split.margin.right;
-		bpack1.h = h1;
-
-		if(_parent != nullptr) {
-			assert(bpack0.w >= pack0_width);
-			assert(bpack0.h >= pack0_height);
-			assert(bpack1.w >= pack1_width);
-			assert(bpack1.h >= pack1_height);
-		}
+	split_children_allocation(*_ctx->theme(), _type, allocation(), split,
+			pack0_width, pack0_height, pack1_width, pack1_height, bpack0, bpack1);
 
+	if(_parent != nullptr) {
+		assert(bpack0.w >= pack0_width);
+		assert(bpack0.h >= pack0_height);
+		assert(bpack1.w >= pack1_width);
+		assert(bpack1.h >= pack1_height);
 	}
 
-
 }
 
-void split_t::update_allocation() {
+/**
+ * Layout children, if skip_unchanged is true, children that keep their
+ * allocation are not laid out again, e.g. when only the ratio change.
+ **/
+void split_t::update_allocation(bool skip_unchanged) {
+	auto previous_bpack0 = _bpack0;
+	auto previous_bpack1 = _bpack1;
 	//cout << "allocation = " << _allocation.to_string() << endl;
 	compute_children_allocation(_ratio, _bpack0, _bpack1);
 	//cout << "allocation pack0 = " << _bpack0.to_string() << endl;
 	//cout << "allocation pack1 = " << _bpack1.to_string() << endl;
-	_split_bar_area = compute_split_bar_location();
-	if(_pack0 != nullptr)
+
+	if (skip_unchanged) {
+		/* children redraw their own areas, only the bar move */
+		queue_redraw_area(_split_bar_area);
+		_split_bar_area = compute_split_bar_location();
+		queue_redraw_area(_split_bar_area);
+	} else {
+		_split_bar_area = compute_split_bar_location();
+		/* margins are not owned by children, redraw them too */
+		queue_redraw_area(_allocation);
+	}
+
+	if(_pack0 != nullptr and (not skip_unchanged or _bpack0 != previous_bpack0))
 		_pack0->set_allocation(_bpack0);
-	if(_pack1 != nullptr)
+	if(_pack1 != nullptr and (not skip_unchanged or _bpack1 != previous_bpack1))
 		_pack1->set_allocation(_bpack1);
 
 }
@@ -214,19 +165,7 @@ void split_t::remove(shared_ptr<tree_t> t) {
 }
 
 rect split_t::compute_split_bar_location(rect const & bpack0, rect const & bpack1) const {
-	rect ret;
-	if (_type == VERTICAL_SPLIT) {
-		ret.x = allocation().x + _ctx->theme()->split.margin.left + bpack0.w ;
-		ret.y = allocation().y;
-		ret.w = _ctx->theme()->split.width + _ctx->theme()->split.margin.left + _ctx->theme()->split.margin.right;
-		ret.h = allocation().h;
-	} else {
-		ret.x = allocation().x;
-		ret.y = allocation().y + _ctx->theme()->split.margin.top + bpack0.h ;
-		ret.w = allocation().w;
-		ret.h = _ctx->theme()->split.width + _ctx->theme()->split.margin.top + _ctx->theme()->split.margin.bottom;
-	}
-	return ret;
+	return split_bar_location(*_ctx->theme(), _type, allocation(), bpack0);
 }
 
 rect split_t::compute_split_bar_location() const {
@@ -237,6 +176,9 @@ auto split_t::button_press(ClutterEvent const * e)  -> button_action_e
 {
 	gfloat x, y;
 	clutter_event_get_coords(e, &x, &y);
+	auto winpos = get_window_position();
+	x -= winpos.x;
+	y -= winpos.y;
 	auto button = clutter_event_get_button(e);
 	auto time = clutter_event_get_time(e);
 
@@ -269,13 +211,8 @@ void split_t::get_min_allocation(int & width, int & height) const {
 	if(_pack1 != nullptr)
 		_pack1->get_min_allocation(pack1_width, pack1_height);
 
-	if (_type == VERTICAL_SPLIT) {
-		width = pack0_width + pack1_width + _ctx->theme()->split.width;
-		height = std::max(pack0_height, pack1_height);
-	} else {
-		width = std::max(pack0_width, pack1_width);
-		height = pack0_height + pack1_height + _ctx->theme()->split.width;
-	}
+	split_min_allocation(*_ctx->theme(), _type, pack0_width, pack0_height,
+			pack1_width, pack1_height, width, height);
 }
 
 double split_t::compute_split_constaint(double split) {
@@ -307,6 +244,9 @@ void split_t::compute_children_root_allocation(double split, rect & bpack0, rect
 bool split_t::button_motion(ClutterEvent const * e) {
 	gfloat x, y;
 	clutter_event_get_coords(e, &x, &y);
+	auto winpos = get_window_position();
+	x -= winpos.x;
+	y -= winpos.y;
 	auto time = clutter_event_get_time(e);
 
 	if(_split_bar_area.is_inside(x, y)) {
@@ -334,5 +274,18 @@ bool split_t::leave(ClutterEvent const * ev) {
 	return false;
 }
 
+auto split_t::pointer_target(int x, int y) -> tree_t * {
+	if (_split_bar_area.is_inside(x, y))
+		return this;
+	if (_pack0 != nullptr and _pack0->allocation().is_inside(x, y))
+		return _pack0->pointer_target(x, y);
+	if (_pack1 != nullptr and _pack1->allocation().is_inside(x, y))
+		return _pack1->pointer_target(x, y);
+	return nullptr;
+}
+
+void split_t::queue_redraw() {
+	queue_redraw_area(_split_bar_area);
+}
 
 }
@@ -38,7 +38,7 @@ class split_t : public page_component_t {
 	rect compute_split_bar_location(rect const & bpack0, rect const & bpack1) const;
 	rect compute_split_bar_location() const;
 
-	void update_allocation();
+	void update_allocation(bool skip_unchanged = false);
 	shared_ptr<split_t> shared_from_this();
 
 public:
@@ -83,7 +83,8 @@ public:
 
 	//virtual auto get_xid() const -> xcb_window_t;
 	//virtual rect get_window_position() const;
-	//virtual void queue_redraw();
+	virtual auto pointer_target(int x, int y) -> tree_t * override;
+	virtual void queue_redraw() override;
 
 	/**
 	 * page_component_t virtual API
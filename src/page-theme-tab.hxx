@@ -35,6 +35,17 @@ struct theme_tab_t {
 		tab_color{x.tab_color}
 	{ }
 
+	bool operator==(theme_tab_t const & x) const {
+		return position == x.position
+			and title == x.title
+			and is_iconic == x.is_iconic
+			and tab_color == x.tab_color;
+	}
+
+	bool operator!=(theme_tab_t const & x) const {
+		return not (*this == x);
+	}
+
 };
 
 }
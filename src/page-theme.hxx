@@ -16,6 +16,7 @@
 #include <cairo.h>
 
 #include "page-color.hxx"
+#include "page-utils.hxx"
 
 #include "page-theme-split.hxx"
 #include "page-theme-managed-window.hxx"
@@ -117,6 +118,9 @@ public:
 	virtual color_t const & get_normal_color() const = 0;
 	virtual color_t const & get_mouse_over_color() const = 0;
 
+	/** emitted when get_background() change outside of update() **/
+	signal_t<theme_t *> on_background_change;
+
 };
 
 }
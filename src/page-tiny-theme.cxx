@@ -457,7 +457,7 @@ void tiny_theme_t::render_notebook_selected(
 	cairo_rectangle_arc_corner(cr, b.x, b.y, b.w, b.h+30.0, 6.5, CAIRO_CORNER_TOP);
 	cairo_clip(cr);
 
-	if(has_background) {
+	if(backgroun_px != nullptr) {
 		cairo_set_source_surface(cr, backgroun_px, -n.root_x, -n.root_y);
 	} else {
 		cairo_set_source_color(cr, default_background_color);
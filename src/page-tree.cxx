@@ -13,6 +13,7 @@
 
 #include "page-utils.hxx"
 #include "page-workspace.hxx"
+#include "page-view.hxx"
 
 namespace page {
 
@@ -93,6 +94,7 @@ void tree_t::remove(shared_ptr<tree_t> t) {
 	assert(has_key(_children, t));
 	_children.remove(t);
 	t->clear_parent();
+	_on_children_change();
 }
 
 void tree_t::clear()
@@ -100,6 +102,7 @@ void tree_t::clear()
 	for(auto x: _children)
 		x->clear_parent();
 	_children.clear();
+	_on_children_change();
 }
 
 void tree_t::detach_myself()
@@ -117,6 +120,7 @@ void tree_t::push_back(tree_p t)
 
 	// TODO: remove this HACK.
 	t->_root = _root;
+	_on_children_change();
 }
 
 void tree_t::push_front(tree_p t)
@@ -127,6 +131,7 @@ void tree_t::push_front(tree_p t)
 
 	// TODO: remove this HACK.
 	t->_root = _root;
+	_on_children_change();
 }
 
 
@@ -161,7 +166,10 @@ void tree_t::raise(shared_ptr<tree_t> t) {
 
 	if(t != nullptr and not _stack_is_locked) {
 		assert(has_key(_children, t));
-		move_back(_children, t);
+		if(_children.back() != t) {
+			move_back(_children, t);
+			_on_children_change();
+		}
 	}
 
 }
@@ -212,16 +220,91 @@ rect tree_t::get_window_position() const {
 		return rect { };
 }
 
+/**
+ * Return the top most node that handle pointer events at (x, y), relative
+ * to get_window_position(), or nullptr. By default look within children.
+ **/
+auto tree_t::pointer_target(int x, int y) -> tree_t * {
+	for (auto const & c : reversed(_children)) {
+		auto t = c->pointer_target(x, y);
+		if (t != nullptr)
+			return t;
+	}
+	return nullptr;
+}
+
 void tree_t::queue_redraw() {
 	if (_parent != nullptr)
 		_parent->queue_redraw();
 }
 
+void tree_t::queue_redraw_area(rect const & area) {
+	if (_parent != nullptr)
+		_parent->queue_redraw_area(area);
+}
+
 auto tree_t::get_default_view() const -> ClutterActor *
 {
 	return nullptr;
 }
 
+void tree_t::_on_children_change() {
+	if (_parent != nullptr)
+		_parent->_on_children_change();
+}
+
+void tree_t::_register_children_root_first(tree_registry_t & reg) const
+{
+	for (auto const & x : _children) {
+		if (auto t = dynamic_cast<view_t *>(x.get()))
+			reg.views.push_back(t);
+		else if (auto t = dynamic_cast<notebook_t *>(x.get()))
+			reg.notebooks.push_back(t);
+		else if (auto t = dynamic_cast<split_t *>(x.get()))
+			reg.splits.push_back(t);
+		else if (auto t = dynamic_cast<viewport_t *>(x.get()))
+			reg.viewports.push_back(t);
+		x->_register_children_root_first(reg);
+	}
+}
+
+/**
+ * Rebuild the registry from root if it has been invalidated.
+ **/
+void tree_registry_t::update(tree_t const * root) {
+	if (is_valid)
+		return;
+
+	/* clear keep the capacity, thus no allocation once the tree is stable */
+	views.clear();
+	notebooks.clear();
+	splits.clear();
+	viewports.clear();
+
+	root->_register_children_root_first(*this);
+	is_valid = true;
+}
+
+template<>
+auto tree_registry_t::get<view_t>() const -> vector<view_t *> const & {
+	return views;
+}
+
+template<>
+auto tree_registry_t::get<notebook_t>() const -> vector<notebook_t *> const & {
+	return notebooks;
+}
+
+template<>
+auto tree_registry_t::get<split_t>() const -> vector<split_t *> const & {
+	return splits;
+}
+
+template<>
+auto tree_registry_t::get<viewport_t>() const -> vector<viewport_t *> const & {
+	return viewports;
+}
+
 /**
  * Print the tree recursively using node names.
  **/
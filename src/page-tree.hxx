@@ -33,6 +33,33 @@ namespace page {
 
 using namespace std;
 
+/**
+ * Typed lists of the nodes of a sub-tree, in stack order. They are only
+ * rebuilt after the sub-tree structure changed, thus typed queries do not
+ * walk the tree nor cast every node.
+ **/
+struct tree_registry_t {
+	bool is_valid;
+
+	vector<view_t *> views;
+	vector<notebook_t *> notebooks;
+	vector<split_t *> splits;
+	vector<viewport_t *> viewports;
+
+	tree_registry_t() : is_valid{false} { }
+
+	void update(tree_t const * root);
+
+	template<typename T>
+	auto get() const -> vector<T *> const &;
+
+};
+
+template<> auto tree_registry_t::get<view_t>() const -> vector<view_t *> const &;
+template<> auto tree_registry_t::get<notebook_t>() const -> vector<notebook_t *> const &;
+template<> auto tree_registry_t::get<split_t>() const -> vector<split_t *> const &;
+template<> auto tree_registry_t::get<viewport_t>() const -> vector<viewport_t *> const &;
+
 /**
  * tree_t is the base of the hierarchy of workspace, viewports,
  * client_managed and unmanaged, etc...
@@ -118,6 +145,14 @@ protected:
 		}
 	}
 
+	/**
+	 * Called when children of this node are added, removed or
+	 * restacked, forward to the parent by default.
+	 **/
+	virtual void _on_children_change();
+
+	void _register_children_root_first(tree_registry_t & reg) const;
+
 	/**
 	 * Parent must exist or beeing NULL, when a node is destroyed, he must
 	 * clear children _parent.
@@ -138,6 +173,8 @@ public:
 	void set_parent(tree_t * parent);
 	void clear_parent();
 
+	friend struct tree_registry_t;
+
 public:
 	tree_t(workspace_t * root);
 
@@ -205,7 +242,9 @@ public:
 	virtual bool enter(ClutterEvent const * ev);
 
 	virtual rect get_window_position() const;
+	virtual auto pointer_target(int x, int y) -> tree_t *;
 	virtual void queue_redraw();
+	virtual void queue_redraw_area(rect const & area);
 
 	virtual auto get_default_view() const -> ClutterActor *;
 
@@ -7,20 +7,233 @@
 
 #include "page-utils.hxx"
 
+#include <atomic>
+
 namespace page {
 
 uint32_t g_log_flags = 0u;
 
 FILE * log::log_file = stdout;
 
-void log(log_module_e module, char const * fmt, ...) {
-	if (module == LOG_NONE or (module&g_log_flags)) {
-		va_list l;
-		va_start(l, fmt);
-		std:vfprintf(log::log_file, fmt, l);
-		va_end(l);
-		fflush(log::log_file);
+namespace {
+
+/**
+ * Multiple producers, single consumer ring of fixed size log lines.
+ **/
+struct log_ring_t {
+	static unsigned const slot_count = 1024;
+
+	/** max time the drain thread sleep before checking the ring **/
+	static gint64 const idle_wait_us = 100000;
+
+	struct slot_t {
+		atomic<bool> ready;
+		int len;
+		char data[log::line_max];
+	};
+
+	slot_t _slots[slot_count];
+	atomic<uint64_t> _head; // next slot to reserve
+	atomic<uint64_t> _tail; // next slot to write out
+	atomic<uint64_t> _dropped;
+	atomic<bool> _running;
+
+	/* held by the drain thread while it writes to log::log_file */
+	GMutex _lock;
+	GCond _cond;
+	/* signaled after each drain pass */
+	GCond _drained;
+	GThread * _thread;
+	gsize _thread_started;
+
+	log_ring_t() :
+		_head{0},
+		_tail{0},
+		_dropped{0},
+		_running{true},
+		_thread{nullptr},
+		_thread_started{0}
+	{
+		for (auto & x: _slots)
+			x.ready.store(false, memory_order_relaxed);
+		g_mutex_init(&_lock);
+		g_cond_init(&_cond);
+		g_cond_init(&_drained);
+	}
+
+	~log_ring_t() {
+		if (_thread != nullptr) {
+			g_mutex_lock(&_lock);
+			_running.store(false);
+			g_cond_signal(&_cond);
+			g_mutex_unlock(&_lock);
+			g_thread_join(_thread);
+		}
+		g_cond_clear(&_drained);
+		g_cond_clear(&_cond);
+		g_mutex_clear(&_lock);
+	}
+
+	void start() {
+		if (g_once_init_enter(&_thread_started)) {
+			_thread = g_thread_new("page-log", &log_ring_t::_drain_thread, this);
+			g_once_init_leave(&_thread_started, 1);
+		}
+	}
+
+	void push(char const * str, int len) {
+		start();
+
+		uint64_t head = _head.load(memory_order_relaxed);
+		do {
+			if (head - _tail.load(memory_order_acquire) >= slot_count) {
+				_dropped.fetch_add(1, memory_order_relaxed);
+				return;
+			}
+		} while (not _head.compare_exchange_weak(head, head + 1, memory_order_acq_rel));
+
+		auto & slot = _slots[head % slot_count];
+		/* longer lines are truncated, like formatted ones */
+		slot.len = std::max(0, std::min<int>(len, sizeof(slot.data)));
+		std::memcpy(slot.data, str, slot.len);
+		slot.ready.store(true, memory_order_release);
+
+		/**
+		 * the drain thread only sleep when the ring is empty. If the lock
+		 * is busy the drain thread is awake and will see this slot before
+		 * it sleeps again, thus we never wait for its I/O.
+		 **/
+		if (head == _tail.load(memory_order_acquire) and g_mutex_trylock(&_lock)) {
+			g_cond_signal(&_cond);
+			g_mutex_unlock(&_lock);
+		}
+	}
+
+	/** write out all published slots, return true if something was written **/
+	bool write_pending() {
+		bool written = false;
+		uint64_t tail = _tail.load(memory_order_relaxed);
+		while (true) {
+			auto & slot = _slots[tail % slot_count];
+			if (not slot.ready.load(memory_order_acquire))
+				break;
+			std::fwrite(slot.data, 1, slot.len, log::log_file);
+			slot.ready.store(false, memory_order_relaxed);
+			_tail.store(++tail, memory_order_release);
+			written = true;
+		}
+
+		auto dropped = _dropped.exchange(0, memory_order_relaxed);
+		if (dropped > 0) {
+			std::fprintf(log::log_file, "log: %lu messages dropped\n", static_cast<unsigned long>(dropped));
+			written = true;
+		}
+
+		return written;
+	}
+
+	bool is_empty() const {
+		return _tail.load(memory_order_acquire) == _head.load(memory_order_acquire);
+	}
+
+	static gpointer _drain_thread(gpointer data) {
+		auto ring = reinterpret_cast<log_ring_t *>(data);
+		g_mutex_lock(&ring->_lock);
+		while (true) {
+			if (ring->write_pending())
+				std::fflush(log::log_file);
+			g_cond_broadcast(&ring->_drained);
+			if (not ring->_running.load())
+				break;
+			if (ring->is_empty())
+				g_cond_wait_until(&ring->_cond, &ring->_lock, g_get_monotonic_time() + idle_wait_us);
+		}
+		g_mutex_unlock(&ring->_lock);
+		return nullptr;
+	}
+
+	void flush() {
+		start();
+		g_mutex_lock(&_lock);
+		while (not is_empty()) {
+			g_cond_signal(&_cond);
+			g_cond_wait(&_drained, &_lock);
+		}
+		g_mutex_unlock(&_lock);
+	}
+
+	void set_file(FILE * file) {
+		flush();
+		g_mutex_lock(&_lock);
+		FILE * old = log::log_file;
+		log::log_file = file;
+		g_mutex_unlock(&_lock);
+		if (old != stdout and old != stderr)
+			std::fclose(old);
+	}
+
+};
+
+log_ring_t g_log_ring;
+
+}
+
+void log::push(char const * str, int len) {
+	g_log_ring.push(str, len);
+}
+
+void log::flush() {
+	g_log_ring.flush();
+}
+
+void log::set_file(char const * filename) {
+	FILE * file = std::fopen(filename, "w");
+	if (file == nullptr)
+		return;
+	g_log_ring.set_file(file);
+}
+
+void log::set_modules(char const * names) {
+	static struct {
+		char const * name;
+		log_module_e module;
+	} const modules[] = {
+		{"all", LOG_ALL},
+		{"configure-request", LOG_CONFIGURE_REQUEST},
+		{"buttons", LOG_BUTTONS},
+		{"focus", LOG_FOCUS},
+		{"leave-enter", LOG_LEAVE_ENTER},
+		{"manage", LOG_MANAGE},
+		{"protocol", LOG_PROTOCOL},
+		{"render", LOG_RENDER},
+		{"restack", LOG_RESTACK},
+		{"menu", LOG_MENU},
+		{"keybinding", LOG_KEYBINDING},
+		{"plugin", LOG_PLUGIN},
+		{"screen", LOG_SCREEN},
+		{"workspace", LOG_WORKSPACE},
+		{"grab", LOG_GRAB}
+	};
+
+	if (names == nullptr)
+		return;
+
+	uint32_t flags = LOG_NONE;
+	gchar ** tokens = g_strsplit(names, ",", -1);
+	for (gchar ** x = tokens; *x != nullptr; ++x) {
+		gchar * name = g_strstrip(*x);
+		bool found = false;
+		for (auto const & m: modules) {
+			if (std::strcmp(name, m.name) == 0) {
+				flags |= m.module;
+				found = true;
+			}
+		}
+		if (not found and name[0] != '\0')
+			log::printf("unknown log module '%s'\n", name);
 	}
+	g_strfreev(tokens);
+	g_log_flags = flags;
 }
 
 /**
@@ -60,11 +60,17 @@ enum log_module_e : uint32_t {
 	LOG_FOCUS = 1u << 2,
 	LOG_LEAVE_ENTER = 1u << 3,
 	LOG_MANAGE = 1u << 4,
-	LOG_PROTOCOL = 1u << 5
+	LOG_PROTOCOL = 1u << 5,
+	LOG_RENDER = 1u << 6,
+	LOG_RESTACK = 1u << 7,
+	LOG_MENU = 1u << 8,
+	LOG_KEYBINDING = 1u << 9,
+	LOG_PLUGIN = 1u << 10,
+	LOG_SCREEN = 1u << 11,
+	LOG_WORKSPACE = 1u << 12,
+	LOG_GRAB = 1u << 13
 };
 
-void log(log_module_e module, char const * fmt, ...);
-
 /**
  * TRICK to compile time checking.
  **/
@@ -962,27 +968,52 @@ public:
 
 };
 
+/**
+ * Log sink, messages are formatted by the caller into a lock-free ring
+ * buffer that a background thread write to log_file, thus the caller never
+ * block on I/O. When the ring is full messages are dropped and counted.
+ **/
 struct log {
+	static int const line_max = 512;
+
 	static FILE * log_file;
 
+	static void push(char const * str, int len);
+
 	template<typename ... Args>
-	static void printf(Args ... args) {
-		std::fprintf(log_file, args...);
-		std::fflush(log_file);
+	static void printf(char const * fmt, Args ... args) {
+		char buf[line_max];
+		int len = std::snprintf(buf, sizeof(buf), fmt, args...);
+		if (len < 0)
+			return;
+		push(buf, std::min<int>(len, sizeof(buf) - 1));
 	}
 
+	/** same output as printf("%s", str), '%' is not special **/
 	static void printf(char const * str) {
-		std::fprintf(log_file, "%s", str);
-		std::fflush(log_file);
+		printf("%s", str);
 	}
 
+	/** wait until all pending messages are written **/
+	static void flush();
 
-	static void set_file(char const * filename) {
-		log_file = std::fopen(filename, "w");
-	}
+	static void set_file(char const * filename);
+
+	/** enable modules from a comma separated list of names, e.g. "focus,grab" or "all" **/
+	static void set_modules(char const * names);
 
 };
 
+/**
+ * Log only if module is enabled in g_log_flags, a disabled module cost only
+ * the branch.
+ **/
+template<typename ... Args>
+inline void log(log_module_e module, char const * fmt, Args ... args) {
+	if (module != LOG_NONE and not (module & g_log_flags))
+		return;
+	log::printf(fmt, args...);
+}
 
 
 }
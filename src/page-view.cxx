@@ -65,9 +65,7 @@ void view_t::move_all_window()
 
 	if (_root->is_enable() and _is_visible) {
 		meta_window_unminimize(_client->_meta_window);
-		meta_window_move_resize_frame(_client->_meta_window, FALSE,
-				_client->_absolute_position.x, _client->_absolute_position.y,
-				_client->_absolute_position.w, _client->_absolute_position.h);
+		_ctx->queue_move_resize(_client);
 	} else {
 		log::printf("minimize %p\n", _client->meta_window());
 		meta_window_minimize(_client->_meta_window);
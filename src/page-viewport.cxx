@@ -22,24 +22,37 @@ using namespace std;
 viewport_t::viewport_t(tree_t * ref, rect const & area) :
 		page_component_t{ref},
 		_work_area{area},
-		_subtree{nullptr}
+		_subtree{nullptr},
+		_use_component_actors{_root->_ctx->configuration._render_component_actors},
+		_back_buffer{nullptr},
+		_need_full_upload{true},
+		_repaint_func_id{0},
+		_pointer_over{nullptr}
 {
 	auto n = make_shared<notebook_t>(this);
 	_subtree = static_pointer_cast<page_component_t>(n);
 	push_back(_subtree);
 
-	_canvas = clutter_canvas_new();
-	g_object_ref_sink(_canvas);
+	_image = clutter_image_new();
 	_default_view = clutter_actor_new();
 	g_object_ref_sink(_default_view);
-	clutter_actor_set_content(_default_view, _canvas);
-	clutter_actor_set_content_scaling_filters(_default_view,
-			CLUTTER_SCALING_FILTER_NEAREST, CLUTTER_SCALING_FILTER_NEAREST);
+	if (_use_component_actors) {
+		/* same background as draw() */
+		ClutterColor background{0u, 0u, 255u, 255u};
+		clutter_actor_set_background_color(_default_view, &background);
+	} else {
+		clutter_actor_set_content(_default_view, _image);
+		clutter_actor_set_content_scaling_filters(_default_view,
+				CLUTTER_SCALING_FILTER_NEAREST, CLUTTER_SCALING_FILTER_NEAREST);
+	}
 	clutter_actor_set_reactive (_default_view, TRUE);
 
 	_update_canvas();
 
-	g_connect(CLUTTER_CANVAS(_canvas), "draw", &viewport_t::draw);
+	/* render the damaged area just before the stage is painted */
+	_repaint_func_id = clutter_threads_add_repaint_func_full(
+			CLUTTER_REPAINT_FLAGS_PRE_PAINT, &viewport_t::_repaint_func,
+			this, nullptr);
 
 	g_connect(_default_view, "button-press-event",
 			&viewport_t::_handler_button_press_event);
@@ -56,8 +69,13 @@ viewport_t::viewport_t(tree_t * ref, rect const & area) :
 }
 
 viewport_t::~viewport_t() {
-	g_object_unref(_canvas);
+	clutter_threads_remove_repaint_func(_repaint_func_id);
+	for (auto & x: _component_actors)
+		_destroy_component_actor(x.second);
+	g_object_unref(_image);
 	g_object_unref(_default_view);
+	if (_back_buffer != nullptr)
+		cairo_surface_destroy(_back_buffer);
 }
 
 void viewport_t::update_work_area(rect const & area)
@@ -95,6 +113,7 @@ void viewport_t::remove(shared_ptr<tree_t> src) {
 void viewport_t::set_allocation(rect const & area) {
 	_work_area = area;
 	_update_canvas();
+	_root->invalidate_notebook_index();
 	if(_subtree != nullptr)
 		_subtree->set_allocation(rect(0, 0, _work_area.w, _work_area.h));
 	queue_redraw();
@@ -119,6 +138,10 @@ void viewport_t::on_workspace_enable()
 	auto _ctx = _root->_ctx;
 	auto _dpy = _root->_ctx->dpy();
 	reconfigure();
+
+	/* damage may have been collected while the workspace was disabled */
+	if (not _damaged.empty())
+		_ctx->schedule_repaint();
 }
 
 void viewport_t::on_workspace_disable()
@@ -142,22 +165,45 @@ void viewport_t::show() {
 	reconfigure();
 }
 
-void viewport_t::draw(ClutterCanvas * _, cairo_t * cr, int width, int height) {
-	log::printf("call %s\n", __PRETTY_FUNCTION__);
+static bool _has_intersection(vector<rect> const & rects, rect const & area)
+{
+	for (auto const & r: rects) {
+		if (r.has_intersection(area))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Render the given area of the viewport, area must include the whole
+ * area of each split bar and notebook that it intersect.
+ **/
+void viewport_t::draw(cairo_t * cr, region const & area) {
+	log(LOG_RENDER, "call %s\n", __PRETTY_FUNCTION__);
+
+	auto rects = area.rects();
 
 	cairo_save(cr);
 	cairo_identity_matrix(cr);
+	cairo_new_path(cr);
+	for (auto const & r: rects)
+		cairo_rectangle(cr, r.x, r.y, r.w, r.h);
+	::cairo_clip(cr);
 	cairo_set_source_rgb(cr, 0.0, 0.0, 1.0);
 	cairo_paint(cr);
+	cairo_restore(cr);
+
+	cairo_save(cr);
+	cairo_identity_matrix(cr);
 
-	auto splits = gather_children_root_first<split_t>();
-	for (auto x : splits) {
-		x->render_legacy(cr);
+	for (auto x : registered<split_t>()) {
+		if (_has_intersection(rects, x->get_split_bar_area()))
+			x->render_legacy(cr);
 	}
 
-	auto notebooks = gather_children_root_first<notebook_t>();
-	for (auto x : notebooks) {
-		x->render_legacy(cr);
+	for (auto x : registered<notebook_t>()) {
+		if (_has_intersection(rects, x->allocation()))
+			x->render_legacy(cr);
 	}
 
 	cairo_restore(cr);
@@ -166,10 +212,210 @@ void viewport_t::draw(ClutterCanvas * _, cairo_t * cr, int width, int height) {
 
 void viewport_t::_update_canvas()
 {
-	clutter_canvas_set_size(CLUTTER_CANVAS(_canvas), _work_area.w, _work_area.h);
 	clutter_actor_set_position(_default_view, _work_area.x, _work_area.y);
 	clutter_actor_set_size(_default_view, _work_area.w, _work_area.h);
-	clutter_content_invalidate(_canvas);
+
+	if (_use_component_actors) {
+		_damaged = region{0, 0, _work_area.w, _work_area.h};
+		return;
+	}
+
+	if (_back_buffer != nullptr
+			and cairo_image_surface_get_width(_back_buffer) == _work_area.w
+			and cairo_image_surface_get_height(_back_buffer) == _work_area.h)
+		return;
+
+	if (_back_buffer != nullptr)
+		cairo_surface_destroy(_back_buffer);
+
+	_back_buffer = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+			_work_area.w, _work_area.h);
+	_need_full_upload = true;
+	_damaged = region{0, 0, _work_area.w, _work_area.h};
+}
+
+/**
+ * Render damaged area into the back buffer and upload only the updated
+ * rectangles to the texture.
+ **/
+void viewport_t::_repaint()
+{
+	if (_damaged.empty())
+		return;
+
+	/* keep damages until the workspace is shown */
+	if (not _root->is_enable())
+		return;
+
+	region area = _damaged & region{0, 0, _work_area.w, _work_area.h};
+	_damaged.clear();
+
+	if (_use_component_actors) {
+		_repaint_component_actors(area);
+		return;
+	}
+
+	/**
+	 * Split bars and notebooks always render their whole area, thus extend
+	 * the damaged area to all components it touch to keep the back buffer
+	 * consistent. They do not overlap, one pass is enough.
+	 **/
+	auto rects = area.rects();
+	auto extended = rects;
+	for (auto x : registered<split_t>()) {
+		if (_has_intersection(rects, x->get_split_bar_area()))
+			extended.push_back(x->get_split_bar_area());
+	}
+
+	for (auto x : registered<notebook_t>()) {
+		if (_has_intersection(rects, x->allocation()))
+			extended.push_back(x->allocation());
+	}
+
+	if (extended.size() != rects.size())
+		area = region::from_rects(extended) & region{0, 0, _work_area.w, _work_area.h};
+
+	if (area.empty())
+		return;
+
+	cairo_t * cr = cairo_create(_back_buffer);
+	draw(cr, area);
+	cairo_destroy(cr);
+	cairo_surface_flush(_back_buffer);
+
+	auto data = cairo_image_surface_get_data(_back_buffer);
+	auto stride = cairo_image_surface_get_stride(_back_buffer);
+
+	GError * err = nullptr;
+	if (_need_full_upload) {
+		if (not clutter_image_set_data(CLUTTER_IMAGE(_image), data,
+				CLUTTER_CAIRO_FORMAT_ARGB32, _work_area.w, _work_area.h,
+				stride, &err)) {
+			log::printf("fail to upload viewport: %s\n", err->message);
+			g_error_free(err);
+			return;
+		}
+		_need_full_upload = false;
+	} else {
+		for (auto const & r: area.rects()) {
+			cairo_rectangle_int_t xr = {r.x, r.y, r.w, r.h};
+			if (not clutter_image_set_area(CLUTTER_IMAGE(_image),
+					data + r.y * stride + r.x * 4,
+					CLUTTER_CAIRO_FORMAT_ARGB32, &xr, stride, &err)) {
+				log::printf("fail to upload viewport area: %s\n", err->message);
+				g_error_free(err);
+				err = nullptr;
+				_need_full_upload = true;
+			}
+		}
+	}
+
+}
+
+template<typename T>
+void viewport_t::_update_component_actor(T * node, rect const & area, vector<rect> const & damaged)
+{
+	auto & x = _component_actors[node];
+	x.is_used = true;
+
+	if (x.actor == nullptr) {
+		x.image = clutter_image_new();
+		x.actor = clutter_actor_new();
+		clutter_actor_set_content(x.actor, x.image);
+		clutter_actor_set_content_scaling_filters(x.actor,
+				CLUTTER_SCALING_FILTER_NEAREST, CLUTTER_SCALING_FILTER_NEAREST);
+		clutter_actor_add_child(_default_view, x.actor);
+	}
+
+	bool need_render = x.surface == nullptr or x.area.w != area.w
+			or x.area.h != area.h or _has_intersection(damaged, area);
+
+	if (x.area != area) {
+		clutter_actor_set_position(x.actor, area.x, area.y);
+		clutter_actor_set_size(x.actor, area.w, area.h);
+		x.area = area;
+	}
+
+	if (not need_render or area.w <= 0 or area.h <= 0)
+		return;
+
+	if (x.surface == nullptr
+			or cairo_image_surface_get_width(x.surface) != area.w
+			or cairo_image_surface_get_height(x.surface) != area.h) {
+		if (x.surface != nullptr)
+			cairo_surface_destroy(x.surface);
+		x.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, area.w, area.h);
+	}
+
+	cairo_t * cr = cairo_create(x.surface);
+	cairo_set_source_rgb(cr, 0.0, 0.0, 1.0);
+	cairo_paint(cr);
+	cairo_translate(cr, -area.x, -area.y);
+	node->render_legacy(cr);
+	cairo_destroy(cr);
+	cairo_surface_flush(x.surface);
+
+	GError * err = nullptr;
+	if (not clutter_image_set_data(CLUTTER_IMAGE(x.image),
+			cairo_image_surface_get_data(x.surface),
+			CLUTTER_CAIRO_FORMAT_ARGB32, area.w, area.h,
+			cairo_image_surface_get_stride(x.surface), &err)) {
+		log::printf("fail to upload component: %s\n", err->message);
+		g_error_free(err);
+		/* try again at next repaint */
+		cairo_surface_destroy(x.surface);
+		x.surface = nullptr;
+	}
+}
+
+void viewport_t::_destroy_component_actor(component_actor_t & x)
+{
+	if (x.actor != nullptr)
+		clutter_actor_destroy(x.actor);
+	if (x.image != nullptr)
+		g_object_unref(x.image);
+	if (x.surface != nullptr)
+		cairo_surface_destroy(x.surface);
+}
+
+/**
+ * Update one actor per split bar and notebook, only damaged ones are
+ * rendered and uploaded, others are only moved if needed.
+ **/
+void viewport_t::_repaint_component_actors(region const & area)
+{
+	auto rects = area.rects();
+
+	for (auto & x: _component_actors)
+		x.second.is_used = false;
+
+	for (auto x : registered<split_t>())
+		_update_component_actor(x, x->get_split_bar_area(), rects);
+
+	for (auto x : registered<notebook_t>())
+		_update_component_actor(x, x->allocation(), rects);
+
+	/* remove actors of removed components */
+	for (auto i = _component_actors.begin(); i != _component_actors.end();) {
+		if (i->second.is_used) {
+			++i;
+		} else {
+			_destroy_component_actor(i->second);
+			i = _component_actors.erase(i);
+		}
+	}
+}
+
+void viewport_t::_on_children_change()
+{
+	_registry.is_valid = false;
+	tree_t::_on_children_change();
+}
+
+gboolean viewport_t::_repaint_func(gpointer data)
+{
+	reinterpret_cast<viewport_t *>(data)->_repaint();
+	return TRUE;
 }
 
 rect viewport_t::get_window_position() const
@@ -180,9 +426,14 @@ rect viewport_t::get_window_position() const
 /* mark renderable_page for redraw */
 void viewport_t::queue_redraw()
 {
+	queue_redraw_area(rect{0, 0, _work_area.w, _work_area.h});
+}
+
+/* mark an area, relative to the viewport, for redraw */
+void viewport_t::queue_redraw_area(rect const & area)
+{
+	_damaged += region{area};
 	_root->_ctx->schedule_repaint();
-	if(_canvas)
-		clutter_content_invalidate(_canvas);
 }
 
 auto viewport_t::get_default_view() const -> ClutterActor *
@@ -190,12 +441,41 @@ auto viewport_t::get_default_view() const -> ClutterActor *
 	return _default_view;
 }
 
+auto viewport_t::_pointer_target(ClutterEvent const * ev) -> tree_t *
+{
+	gfloat x, y;
+	clutter_event_get_coords(ev, &x, &y);
+	return pointer_target(x - _work_area.x, y - _work_area.y);
+}
+
+/**
+ * Send leave to the node previously under the pointer if it changed.
+ **/
+void viewport_t::_update_pointer_over(tree_t * target, ClutterEvent const * ev)
+{
+	if (target == _pointer_over)
+		return;
+
+	auto previous = _pointer_over_w.lock();
+	if (previous != nullptr)
+		previous->leave(ev);
+
+	_pointer_over = target;
+	if (target != nullptr)
+		_pointer_over_w = target->shared_from_this();
+	else
+		_pointer_over_w.reset();
+}
+
 auto viewport_t::_handler_button_press_event(ClutterActor * actor, ClutterEvent * event) -> gboolean
 {
 //	log::printf("call %s\n", __PRETTY_FUNCTION__);
 
-	if (not _root->_ctx->has_grab_handler())
-		broadcast_button_press(event);
+	if (not _root->_ctx->has_grab_handler()) {
+		auto target = _pointer_target(event);
+		if (target != nullptr)
+			target->button_press(event);
+	}
 
 	return FALSE;
 }
@@ -204,8 +484,11 @@ auto viewport_t::_handler_button_release_event(ClutterActor * actor, ClutterEven
 {
 //	log::printf("call %s\n", __PRETTY_FUNCTION__);
 
-	if (not _root->_ctx->has_grab_handler())
-		broadcast_button_release(event);
+	if (not _root->_ctx->has_grab_handler()) {
+		auto target = _pointer_target(event);
+		if (target != nullptr)
+			target->button_release(event);
+	}
 
 	return FALSE;
 }
@@ -214,7 +497,10 @@ auto viewport_t::_handler_motion_event(ClutterActor * actor, ClutterEvent * even
 {
 //	log::printf("call %s\n", __PRETTY_FUNCTION__);
 
-	broadcast_button_motion(event);
+	auto target = _pointer_target(event);
+	_update_pointer_over(target, event);
+	if (target != nullptr)
+		target->button_motion(event);
 
 	return FALSE;
 }
@@ -223,7 +509,10 @@ auto viewport_t::_handler_enter_event(ClutterActor * actor, ClutterEvent * event
 {
 //	log::printf("call %s\n", __PRETTY_FUNCTION__);
 
-	broadcast_enter(event);
+	auto target = _pointer_target(event);
+	_update_pointer_over(target, event);
+	if (target != nullptr)
+		target->enter(event);
 
 	return FALSE;
 }
@@ -232,7 +521,7 @@ auto viewport_t::_handler_leave_event(ClutterActor * actor, ClutterEvent * event
 {
 //	log::printf("call %s\n", __PRETTY_FUNCTION__);
 
-	broadcast_leave(event);
+	_update_pointer_over(nullptr, event);
 
 	return FALSE;
 }
@@ -12,8 +12,10 @@
 
 #include <memory>
 #include <vector>
+#include <map>
 
 #include "page-split.hxx"
+#include "page-region.hxx"
 #include "page-theme.hxx"
 #include "page-page-component.hxx"
 #include "page-notebook.hxx"
@@ -27,23 +29,78 @@ class viewport_t:
 		public page_component_t
 {
 
-	/** rendering tabs is time consuming, thus use back buffer **/
-	ClutterContent * _canvas;
-	ClutterActor * _default_view;
-
 	/** the viewport work area **/
 	rect _work_area;
 
 	shared_ptr<page_component_t> _subtree;
 
+	/**
+	 * With the actors backend, each split bar and notebook get its own actor
+	 * and texture, an undamaged component keep its texture when moved.
+	 **/
+	struct component_actor_t {
+		ClutterActor * actor;
+		ClutterContent * image;
+		cairo_surface_t * surface;
+		rect area;
+		bool is_used;
+
+		component_actor_t() :
+			actor{nullptr},
+			image{nullptr},
+			surface{nullptr},
+			area{},
+			is_used{false}
+		{ }
+	};
+
+	bool _use_component_actors;
+	map<tree_t const *, component_actor_t> _component_actors;
+
+	/** rendering tabs is time consuming, thus use back buffer **/
+	ClutterContent * _image;
+	ClutterActor * _default_view;
+	cairo_surface_t * _back_buffer;
+	bool _need_full_upload;
+
+	/** area of the back buffer that must be rendered and uploaded again **/
+	region _damaged;
+	guint _repaint_func_id;
+
+	/** node under the pointer, raw pointer is only used for comparison **/
+	tree_t * _pointer_over;
+	tree_w _pointer_over_w;
+
+	/** typed nodes of the viewport, in stack order **/
+	mutable tree_registry_t _registry;
+
 	viewport_t(viewport_t const & v) = delete;
 	viewport_t & operator= (viewport_t const &) = delete;
 
 	auto get_nearest_notebook() -> shared_ptr<notebook_t>;
 
-	void draw(ClutterCanvas * _, cairo_t * cr, int width, int height);
+	void draw(cairo_t * cr, region const & area);
 
 	void _update_canvas();
+	void _repaint();
+	void _repaint_component_actors(region const & area);
+
+	template<typename T>
+	void _update_component_actor(T * node, rect const & area, vector<rect> const & damaged);
+	void _destroy_component_actor(component_actor_t & x);
+
+	static gboolean _repaint_func(gpointer data);
+
+	virtual void _on_children_change() override;
+
+	auto _pointer_target(ClutterEvent const * ev) -> tree_t *;
+	void _update_pointer_over(tree_t * target, ClutterEvent const * ev);
+
+	template<typename T>
+	auto registered() const -> vector<T *> const & {
+		_registry.update(this);
+		return _registry.get<T>();
+	}
 
 	auto _handler_button_press_event(ClutterActor * actor, ClutterEvent * event) -> gboolean;
 	auto _handler_button_release_event(ClutterActor * actor, ClutterEvent * event) -> gboolean;
@@ -79,6 +136,7 @@ public:
 
 	virtual rect get_window_position() const override;
 	virtual void queue_redraw() override;
+	virtual void queue_redraw_area(rect const & area) override;
 
 	virtual auto get_default_view() const -> ClutterActor *;
 
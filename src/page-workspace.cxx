@@ -91,19 +91,15 @@ void workspace_t::update_viewports_layout()
 	auto screen = meta_plugin_get_screen(_ctx->_plugin);
 	auto n_monitor = meta_screen_get_n_monitors(screen);
 
-	vector<rect> viewport_allocation;
-	region already_allocated;
+	vector<rect> work_areas;
 	for(int monitor_id = 0; monitor_id < n_monitor; ++monitor_id) {
 		MetaRectangle area;
 		meta_workspace_get_work_area_for_monitor(_meta_workspace, monitor_id, &area);
-		region region_to_alocate{rect{area}};
-		region_to_alocate -= already_allocated;
-		for (auto & r: region_to_alocate.rects()) {
-			viewport_allocation.push_back(r);
-		}
-		already_allocated += region_to_alocate;
+		work_areas.push_back(rect{area});
 	}
 
+	auto viewport_allocation = viewports_allocation(work_areas);
+
 	/** get old viewport_allocation to recycle old viewport, and keep unchanged outputs **/
 	auto old_layout = _viewport_outputs;
 	/** store the newer layout, to be able to cleanup obsolete viewports **/
@@ -410,7 +406,7 @@ void workspace_t::switch_fullscreen_to_prefered_view_mode(view_fullscreen_p view
 {
 	view->remove_this_view();
 
-	for(auto v: gather_children_root_first<viewport_t>()) {
+	for(auto v: registered<viewport_t>()) {
 		v->show();
 	}
 
@@ -497,13 +493,57 @@ bool workspace_t::client_focus_history_is_empty() {
 
 auto workspace_t::lookup_view_for(client_managed_p c) const -> view_p
 {
-	for (auto & x: gather_children_root_first<view_t>()) {
+	for (auto x: registered<view_t>()) {
 		if (x->_client == c)
-			return x;
+			return x->shared_from_this();
 	}
 	return nullptr;
 }
 
+void workspace_t::_on_children_change()
+{
+	_registry.is_valid = false;
+	_notebook_index.is_valid = false;
+	tree_t::_on_children_change();
+}
+
+auto workspace_t::notebook_at(int x, int y) const -> notebook_t *
+{
+	if (not _notebook_index.is_valid)
+		_notebook_index.update(registered<notebook_t>());
+	return _notebook_index.lookup(x, y);
+}
+
+void workspace_t::invalidate_notebook_index()
+{
+	_notebook_index.is_valid = false;
+}
+
+void notebook_index_t::update(vector<notebook_t *> const & notebooks)
+{
+	this->notebooks = notebooks;
+
+	vector<rect> areas;
+	for (auto n: notebooks) {
+		auto area = n->allocation();
+		auto window_position = n->get_window_position();
+		area.x += window_position.x;
+		area.y += window_position.y;
+		areas.push_back(area);
+	}
+
+	index.update(areas);
+	is_valid = true;
+}
+
+auto notebook_index_t::lookup(int x, int y) const -> notebook_t *
+{
+	int id = index.lookup(x, y);
+	if (id < 0)
+		return nullptr;
+	return notebooks[id];
+}
+
 void workspace_t::set_focus(view_p new_focus, xcb_timestamp_t time) {
 	if(new_focus) {
 		client_focus_history_move_front(new_focus);
@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "page-utils.hxx"
+#include "page-layout.hxx"
 #include "page-viewport.hxx"
 #include "page-client-managed.hxx"
 #include "page-page-types.hxx"
@@ -27,6 +28,21 @@ enum workspace_switch_direction_e {
 	WORKSPACE_SWITCH_RIGHT
 };
 
+/**
+ * Notebooks by root area, see rect_index_t.
+ **/
+struct notebook_index_t {
+	rect_index_t index;
+	vector<notebook_t *> notebooks;
+	bool is_valid;
+
+	notebook_index_t() : is_valid{false} { }
+
+	void update(vector<notebook_t *> const & notebooks);
+	auto lookup(int x, int y) const -> notebook_t *;
+
+};
+
 struct workspace_t: public tree_t {
 	page_t * _ctx;
 
@@ -57,8 +73,16 @@ private:
 
 	bool _is_enable;
 
+	/** typed nodes of the workspace, in stack order **/
+	mutable tree_registry_t _registry;
+
+	/** notebooks by root area, rebuilt on demand when the layout change **/
+	mutable notebook_index_t _notebook_index;
+
 	void _init();
 
+	virtual void _on_children_change() override;
+
 public:
 	view_w _net_active_window;
 
@@ -126,6 +150,23 @@ public:
 	bool client_focus_history_is_empty();
 
 	auto lookup_view_for(client_managed_p c) const -> view_p;
+
+	/**
+	 * Return nodes of type T in the workspace in stack order, the result
+	 * is valid until the next change of the tree structure.
+	 **/
+	template<typename T>
+	auto registered() const -> vector<T *> const & {
+		_registry.update(this);
+		return _registry.get<T>();
+	}
+
+	/**
+	 * Return the notebook at root position (x, y), or nullptr.
+	 **/
+	auto notebook_at(int x, int y) const -> notebook_t *;
+	void invalidate_notebook_index();
+
 	void set_focus(view_p new_focus, xcb_timestamp_t tfocus);
 	void unmanage(client_managed_p mw);
 
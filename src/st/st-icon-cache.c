@@ -0,0 +1,419 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * st-icon-cache.c: On-disk cache of decoded icons for StTextureCache
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Icons are stored already scaled, as premultiplied RGBA rows ready to be
+ * uploaded with COGL_PIXEL_FORMAT_RGBA_8888_PRE, one file per icon:
+ *
+ *   StIconCacheHeader
+ *   key, padded to 4 bytes
+ *   rowstride * height bytes of pixels
+ *
+ * The file name is a hash of the name given by the caller, which stays
+ * the same when the icon changes, so an updated icon replaces its old
+ * file. The key describes the exact source of the pixels (file, mtime,
+ * theme...) and a file with another key is a miss.
+ *
+ * The directory is kept under ST_ICON_CACHE_MAX_BYTES by deleting the
+ * files with the oldest mtime, a hit touches its file so the files
+ * deleted first are the ones not used for the longest time.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include "st-icon-cache.h"
+
+#define ST_ICON_CACHE_MAGIC   0x43495453 /* "STIC" */
+#define ST_ICON_CACHE_VERSION 1
+
+/* icons larger than this are not worth caching */
+#define ST_ICON_CACHE_MAX_SIZE 1024
+
+/* size of the directory before pruning, pruning goes down to 3/4 of it */
+#define ST_ICON_CACHE_MAX_BYTES (32 * 1024 * 1024)
+
+typedef struct {
+  guint32 magic;
+  guint32 version;
+  guint32 width;
+  guint32 height;
+  guint32 rowstride;
+  guint32 key_length;
+} StIconCacheHeader;
+
+struct _StIconCache
+{
+  char *path;
+
+  /* bytes stored since the last pruning */
+  gsize n_stored;
+};
+
+typedef struct {
+  char *filename;
+  char *key;
+  GdkPixbuf *pixbuf;
+} StoreData;
+
+typedef struct {
+  GFile *file;
+  guint64 size;
+  guint64 mtime;
+} PruneEntry;
+
+static gint
+compare_prune_entries (gconstpointer a,
+                       gconstpointer b)
+{
+  const PruneEntry *entry_a = a;
+  const PruneEntry *entry_b = b;
+
+  /* most recent first */
+  if (entry_a->mtime != entry_b->mtime)
+    return entry_a->mtime > entry_b->mtime ? -1 : 1;
+  return 0;
+}
+
+static void
+prune_thread (GTask        *task,
+              gpointer      source,
+              gpointer      task_data,
+              GCancellable *cancellable)
+{
+  GFile *dir = task_data;
+  GFileEnumerator *enumerator;
+  GFileInfo *info;
+  GArray *entries;
+  guint64 total = 0;
+  guint i;
+
+  enumerator = g_file_enumerate_children (dir,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          NULL, NULL);
+  if (enumerator == NULL)
+    {
+      g_task_return_boolean (task, FALSE);
+      return;
+    }
+
+  entries = g_array_new (FALSE, FALSE, sizeof (PruneEntry));
+
+  while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL)) != NULL)
+    {
+      PruneEntry entry;
+
+      if (g_str_has_suffix (g_file_info_get_name (info), ".icon"))
+        {
+          entry.file = g_file_get_child (dir, g_file_info_get_name (info));
+          entry.size = g_file_info_get_size (info);
+          entry.mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+          total += entry.size;
+          g_array_append_val (entries, entry);
+        }
+
+      g_object_unref (info);
+    }
+
+  g_object_unref (enumerator);
+
+  if (total > ST_ICON_CACHE_MAX_BYTES)
+    {
+      guint64 kept = 0;
+
+      g_array_sort (entries, compare_prune_entries);
+
+      for (i = 0; i < entries->len; i++)
+        {
+          PruneEntry *entry = &g_array_index (entries, PruneEntry, i);
+
+          if (kept + entry->size <= ST_ICON_CACHE_MAX_BYTES / 4 * 3)
+            kept += entry->size;
+          else
+            g_file_delete (entry->file, NULL, NULL);
+        }
+    }
+
+  for (i = 0; i < entries->len; i++)
+    g_object_unref (g_array_index (entries, PruneEntry, i).file);
+  g_array_free (entries, TRUE);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+/* Deletes the least recently used files if the directory is over
+ * ST_ICON_CACHE_MAX_BYTES, in a worker thread */
+static void
+st_icon_cache_prune (StIconCache *cache)
+{
+  GTask *task;
+
+  cache->n_stored = 0;
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_task_data (task, g_file_new_for_path (cache->path), g_object_unref);
+  g_task_run_in_thread (task, prune_thread);
+  g_object_unref (task);
+}
+
+StIconCache *
+st_icon_cache_new (const char *path)
+{
+  StIconCache *cache = g_new0 (StIconCache, 1);
+
+  cache->path = g_strdup (path);
+
+  /* files of a previous session may not fit anymore */
+  st_icon_cache_prune (cache);
+
+  return cache;
+}
+
+void
+st_icon_cache_free (StIconCache *cache)
+{
+  g_free (cache->path);
+  g_free (cache);
+}
+
+static char *
+get_filename (StIconCache *cache,
+              const char  *name)
+{
+  char *checksum;
+  char *basename;
+  char *filename;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, name, -1);
+  basename = g_strconcat (checksum, ".icon", NULL);
+  filename = g_build_filename (cache->path, basename, NULL);
+
+  g_free (checksum);
+  g_free (basename);
+
+  return filename;
+}
+
+/**
+ * st_icon_cache_lookup:
+ * @cache: A #StIconCache
+ * @name: Identity of the icon, see st_icon_cache_store()
+ * @key: Description of the source of the pixels
+ * @width: (out): Width of the icon
+ * @height: (out): Height of the icon
+ * @rowstride: (out): Size of a row, in bytes
+ *
+ * Maps the cache file of @name, this blocks on I/O and is meant to be
+ * called from a worker thread.
+ *
+ * Returns: (transfer full) (nullable): premultiplied RGBA pixels, mapped
+ *   from the cache file, or %NULL if the cache has no icon for @name
+ *   made from @key
+ */
+GBytes *
+st_icon_cache_lookup (StIconCache *cache,
+                      const char  *name,
+                      const char  *key,
+                      int         *width,
+                      int         *height,
+                      int         *rowstride)
+{
+  StIconCacheHeader header;
+  GMappedFile *mapped;
+  GBytes *bytes;
+  GBytes *pixels = NULL;
+  char *filename;
+  const char *contents;
+  gsize length;
+  gsize key_length;
+  gsize offset;
+
+  filename = get_filename (cache, name);
+  mapped = g_mapped_file_new (filename, FALSE, NULL);
+
+  if (mapped == NULL)
+    {
+      g_free (filename);
+      return NULL;
+    }
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  g_mapped_file_unref (mapped);
+
+  contents = g_bytes_get_data (bytes, &length);
+  key_length = strlen (key);
+
+  if (length < sizeof (header))
+    goto out;
+
+  memcpy (&header, contents, sizeof (header));
+
+  if (header.magic != ST_ICON_CACHE_MAGIC ||
+      header.version != ST_ICON_CACHE_VERSION ||
+      header.key_length != key_length ||
+      header.width == 0 || header.width > ST_ICON_CACHE_MAX_SIZE ||
+      header.height == 0 || header.height > ST_ICON_CACHE_MAX_SIZE ||
+      header.rowstride < header.width * 4)
+    goto out;
+
+  offset = sizeof (header) + (key_length + 3) / 4 * 4;
+  if (length != offset + (gsize) header.rowstride * header.height ||
+      memcmp (contents + sizeof (header), key, key_length) != 0)
+    goto out;
+
+  *width = header.width;
+  *height = header.height;
+  *rowstride = header.rowstride;
+  pixels = g_bytes_new_from_bytes (bytes, offset, length - offset);
+
+  /* recently used, see st_icon_cache_prune() */
+  g_utime (filename, NULL);
+
+out:
+  g_free (filename);
+  g_bytes_unref (bytes);
+  return pixels;
+}
+
+static void
+store_data_free (gpointer p)
+{
+  StoreData *data = p;
+
+  g_free (data->filename);
+  g_free (data->key);
+  g_object_unref (data->pixbuf);
+  g_free (data);
+}
+
+static void
+store_thread (GTask        *task,
+              gpointer      source,
+              gpointer      task_data,
+              GCancellable *cancellable)
+{
+  StoreData *data = task_data;
+  StIconCacheHeader header;
+  GdkPixbuf *pixbuf = data->pixbuf;
+  const guchar *src;
+  guchar *contents;
+  guchar *dst;
+  gsize key_length;
+  gsize offset;
+  gsize length;
+  int n_channels;
+  int src_rowstride;
+  int x, y;
+  char *dirname;
+
+  n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+  src_rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  src = gdk_pixbuf_get_pixels (pixbuf);
+
+  key_length = strlen (data->key);
+
+  header.magic = ST_ICON_CACHE_MAGIC;
+  header.version = ST_ICON_CACHE_VERSION;
+  header.width = gdk_pixbuf_get_width (pixbuf);
+  header.height = gdk_pixbuf_get_height (pixbuf);
+  header.rowstride = header.width * 4;
+  header.key_length = key_length;
+
+  offset = sizeof (header) + (key_length + 3) / 4 * 4;
+  length = offset + (gsize) header.rowstride * header.height;
+
+  contents = g_malloc0 (length);
+  memcpy (contents, &header, sizeof (header));
+  memcpy (contents + sizeof (header), data->key, key_length);
+
+  /* premultiply now, so loading is a plain upload */
+  for (y = 0; y < (int) header.height; y++)
+    {
+      const guchar *s = src + y * src_rowstride;
+
+      dst = contents + offset + y * header.rowstride;
+      for (x = 0; x < (int) header.width; x++, s += n_channels, dst += 4)
+        {
+          guint alpha = n_channels == 4 ? s[3] : 0xff;
+
+          dst[0] = (s[0] * alpha + 0x7f) / 0xff;
+          dst[1] = (s[1] * alpha + 0x7f) / 0xff;
+          dst[2] = (s[2] * alpha + 0x7f) / 0xff;
+          dst[3] = alpha;
+        }
+    }
+
+  dirname = g_path_get_dirname (data->filename);
+  g_mkdir_with_parents (dirname, 0700);
+  g_free (dirname);
+
+  /* written to a temporary file then renamed, readers never see a
+   * partial icon */
+  g_file_set_contents (data->filename, (const char *) contents, length, NULL);
+
+  g_free (contents);
+  g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * st_icon_cache_store:
+ * @cache: A #StIconCache
+ * @name: Identity of the icon, an updated icon must keep the same name
+ * @key: Description of the source of the pixels, checked by
+ *   st_icon_cache_lookup()
+ * @pixbuf: The decoded and scaled icon
+ *
+ * Writes @pixbuf to the cache, in a worker thread. The cache is pruned
+ * each time a quarter of its size was written.
+ */
+void
+st_icon_cache_store (StIconCache *cache,
+                     const char  *name,
+                     const char  *key,
+                     GdkPixbuf   *pixbuf)
+{
+  StoreData *data;
+  GTask *task;
+
+  if (gdk_pixbuf_get_colorspace (pixbuf) != GDK_COLORSPACE_RGB ||
+      gdk_pixbuf_get_bits_per_sample (pixbuf) != 8 ||
+      gdk_pixbuf_get_width (pixbuf) == 0 ||
+      gdk_pixbuf_get_height (pixbuf) == 0 ||
+      gdk_pixbuf_get_width (pixbuf) > ST_ICON_CACHE_MAX_SIZE ||
+      gdk_pixbuf_get_height (pixbuf) > ST_ICON_CACHE_MAX_SIZE)
+    return;
+
+  data = g_new0 (StoreData, 1);
+  data->filename = get_filename (cache, name);
+  data->key = g_strdup (key);
+  data->pixbuf = g_object_ref (pixbuf);
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_task_data (task, data, store_data_free);
+  g_task_run_in_thread (task, store_thread);
+  g_object_unref (task);
+
+  cache->n_stored += (gsize) gdk_pixbuf_get_width (pixbuf) * gdk_pixbuf_get_height (pixbuf) * 4;
+  if (cache->n_stored > ST_ICON_CACHE_MAX_BYTES / 4)
+    st_icon_cache_prune (cache);
+}
@@ -0,0 +1,45 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * st-icon-cache.h: On-disk cache of decoded icons for StTextureCache
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ST_ICON_CACHE_H__
+#define __ST_ICON_CACHE_H__
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+typedef struct _StIconCache StIconCache;
+
+StIconCache *st_icon_cache_new    (const char  *path);
+void         st_icon_cache_free   (StIconCache *cache);
+
+GBytes      *st_icon_cache_lookup (StIconCache *cache,
+                                   const char  *name,
+                                   const char  *key,
+                                   int         *width,
+                                   int         *height,
+                                   int         *rowstride);
+
+void         st_icon_cache_store  (StIconCache *cache,
+                                   const char  *name,
+                                   const char  *key,
+                                   GdkPixbuf   *pixbuf);
+
+G_END_DECLS
+
+#endif /* __ST_ICON_CACHE_H__ */
@@ -22,31 +22,92 @@
 #include "config.h"
 
 #include "st-texture-cache.h"
+#include "st-icon-cache.h"
 #include "st-private.h"
 #include <gtk/gtk.h>
 #include <string.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 
 #define CACHE_PREFIX_ICON "icon:"
 #define CACHE_PREFIX_FILE "file:"
 #define CACHE_PREFIX_FILE_FOR_CAIRO "file-for-cairo:"
 
+#define DEFAULT_MAX_BYTES (64 * 1024 * 1024)
+
+/* Size of the pool decoding image files */
+#define MAX_RUNNING_LOADS 4
+
 struct _StTextureCachePrivate
 {
   GtkIconTheme *icon_theme;
 
   /* Things that were loaded with a cache policy != NONE */
-  GHashTable *keyed_cache; /* char * -> CoglTexture* */
+  GHashTable *keyed_cache; /* char * -> StTextureCacheEntry * */
+
+  /* Entries of keyed_cache, most recently used first */
+  GQueue lru;
+  guint64 n_bytes;
+  guint64 max_bytes;
+
+  guint n_hits;
+  guint n_misses;
+  guint n_evictions;
 
   /* Presently this is used to de-duplicate requests for GIcons and async URIs. */
   GHashTable *outstanding_requests; /* char * -> AsyncTextureLoadData * */
 
   /* File monitors to evict cache data on changes */
   GHashTable *file_monitors; /* char * -> GFileMonitor * */
+
+  /* Decoded icons saved across sessions */
+  StIconCache *icon_cache;
+
+  /* File loads waiting for a thread of loader_pool, see
+   * dispatch_pending_loads() for the order */
+  GThreadPool *loader_pool;
+  GQueue pending_loads; /* GTask * */
+  guint n_running_loads;
+  guint dispatch_id;
 };
 
+/* A value of keyed_cache, the cache holds one reference on data */
+typedef struct {
+  StTextureCachePrivate *priv;
+  const char *key; /* owned by keyed_cache */
+
+  gpointer data; /* CoglTexture * or cairo_surface_t * */
+  gboolean is_surface;
+  /* never evicted, the data is used by something the cache does not see */
+  gboolean pinned;
+  gsize n_bytes;
+
+  GList lru_link;
+
+  /* ClutterTextures the texture was set on, weak references */
+  GSList *actors;
+} StTextureCacheEntry;
+
+static void texture_load_data_free (gpointer p);
+static void loader_pool_run (gpointer task, gpointer user_data);
+
 static void st_texture_cache_dispose (GObject *object);
 static void st_texture_cache_finalize (GObject *object);
+static void st_texture_cache_set_property (GObject      *object,
+                                           guint         prop_id,
+                                           const GValue *value,
+                                           GParamSpec   *pspec);
+static void st_texture_cache_get_property (GObject    *object,
+                                           guint       prop_id,
+                                           GValue     *value,
+                                           GParamSpec *pspec);
+
+enum
+{
+  PROP_0,
+
+  PROP_MAX_BYTES
+};
 
 enum
 {
@@ -86,6 +147,25 @@ st_texture_cache_class_init (StTextureCacheClass *klass)
 
   gobject_class->dispose = st_texture_cache_dispose;
   gobject_class->finalize = st_texture_cache_finalize;
+  gobject_class->set_property = st_texture_cache_set_property;
+  gobject_class->get_property = st_texture_cache_get_property;
+
+  /**
+   * StTextureCache:max-bytes:
+   *
+   * Approximate amount of texture memory the cache may keep, least
+   * recently used textures are evicted above it. Textures still shown by
+   * an actor, and textures loaded synchronously with
+   * %ST_TEXTURE_CACHE_POLICY_FOREVER, are never evicted, so the cache can
+   * exceed this value.
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_MAX_BYTES,
+                                   g_param_spec_uint64 ("max-bytes",
+                                                        "Max bytes",
+                                                        "Size of the texture cache before eviction, in bytes",
+                                                        0, G_MAXUINT64, DEFAULT_MAX_BYTES,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   signals[ICON_THEME_CHANGED] =
     g_signal_new ("icon-theme-changed",
@@ -104,6 +184,155 @@ st_texture_cache_class_init (StTextureCacheClass *klass)
                   G_TYPE_NONE, 1, G_TYPE_FILE);
 }
 
+static void
+on_entry_actor_destroyed (gpointer  data,
+                          GObject  *where_the_object_was)
+{
+  StTextureCacheEntry *entry = data;
+
+  entry->actors = g_slist_remove (entry->actors, where_the_object_was);
+}
+
+static void
+cache_entry_free (gpointer data)
+{
+  StTextureCacheEntry *entry = data;
+  GSList *l;
+
+  for (l = entry->actors; l; l = l->next)
+    g_object_weak_unref (l->data, on_entry_actor_destroyed, entry);
+  g_slist_free (entry->actors);
+
+  g_queue_unlink (&entry->priv->lru, &entry->lru_link);
+  entry->priv->n_bytes -= entry->n_bytes;
+
+  if (entry->is_surface)
+    cairo_surface_destroy (entry->data);
+  else
+    cogl_object_unref (entry->data);
+
+  g_free (entry);
+}
+
+/* Whether evicting the entry would free nothing, because the data is
+ * still displayed. The references on CoglTexture are not visible, thus
+ * textures are tracked through the actors they were set on, and textures
+ * handed to callers without an actor are pinned.
+ */
+static gboolean
+cache_entry_in_use (StTextureCacheEntry *entry)
+{
+  GSList *l;
+
+  if (entry->pinned)
+    return TRUE;
+
+  if (entry->is_surface)
+    return cairo_surface_get_reference_count (entry->data) > 1;
+
+  for (l = entry->actors; l; l = l->next)
+    {
+      if (clutter_texture_get_cogl_texture (l->data) == entry->data)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Evicts least recently used entries not in use until the cache fit in
+ * max_bytes */
+static void
+keyed_cache_trim (StTextureCache *cache)
+{
+  StTextureCachePrivate *priv = cache->priv;
+  GList *l;
+
+  if (priv->n_bytes <= priv->max_bytes)
+    return;
+
+  for (l = priv->lru.tail; l && priv->n_bytes > priv->max_bytes; )
+    {
+      StTextureCacheEntry *entry = l->data;
+
+      l = l->prev;
+
+      if (cache_entry_in_use (entry))
+        continue;
+
+      g_hash_table_remove (priv->keyed_cache, entry->key);
+      priv->n_evictions++;
+    }
+}
+
+/* Returns the entry of key, its data has no added reference */
+static StTextureCacheEntry *
+keyed_cache_lookup (StTextureCache *cache,
+                    const char     *key)
+{
+  StTextureCachePrivate *priv = cache->priv;
+  StTextureCacheEntry *entry;
+
+  entry = g_hash_table_lookup (priv->keyed_cache, key);
+  if (entry == NULL)
+    {
+      priv->n_misses++;
+      return NULL;
+    }
+
+  priv->n_hits++;
+  g_queue_unlink (&priv->lru, &entry->lru_link);
+  g_queue_push_head_link (&priv->lru, &entry->lru_link);
+
+  return entry;
+}
+
+/* Takes the ownership of one reference on data, callers call
+ * keyed_cache_trim() once the entry is bound to its actors. Entries not
+ * bound to actors must be pinned to survive a trim.
+ */
+static StTextureCacheEntry *
+keyed_cache_insert (StTextureCache *cache,
+                    const char     *key,
+                    gpointer        data,
+                    gboolean        is_surface,
+                    gboolean        pinned)
+{
+  StTextureCachePrivate *priv = cache->priv;
+  StTextureCacheEntry *entry;
+
+  entry = g_new0 (StTextureCacheEntry, 1);
+  entry->priv = priv;
+  entry->key = g_strdup (key);
+  entry->data = data;
+  entry->is_surface = is_surface;
+  entry->pinned = pinned;
+  entry->lru_link.data = entry;
+
+  if (is_surface)
+    entry->n_bytes = cairo_image_surface_get_stride (data) * cairo_image_surface_get_height (data);
+  else
+    entry->n_bytes = cogl_texture_get_width (data) * cogl_texture_get_height (data) * 4;
+
+  /* A replaced entry is unlinked by cache_entry_free */
+  g_hash_table_replace (priv->keyed_cache, (char *) entry->key, entry);
+  g_queue_push_head_link (&priv->lru, &entry->lru_link);
+  priv->n_bytes += entry->n_bytes;
+
+  return entry;
+}
+
+/* Record that texture shows the data of entry */
+static void
+cache_entry_bind (StTextureCacheEntry *entry,
+                  ClutterTexture      *texture)
+{
+  if (g_slist_find (entry->actors, texture))
+    return;
+
+  g_object_weak_ref (G_OBJECT (texture), on_entry_actor_destroyed, entry);
+  entry->actors = g_slist_prepend (entry->actors, texture);
+}
+
 /* Evicts all cached textures for named icons */
 static void
 st_texture_cache_evict_icons (StTextureCache *cache)
@@ -137,6 +366,8 @@ on_icon_theme_changed (GtkIconTheme   *icon_theme,
 static void
 st_texture_cache_init (StTextureCache *self)
 {
+  char *path;
+
   self->priv = g_new0 (StTextureCachePrivate, 1);
 
   self->priv->icon_theme = gtk_icon_theme_get_default ();
@@ -144,18 +375,47 @@ st_texture_cache_init (StTextureCache *self)
                     G_CALLBACK (on_icon_theme_changed), self);
 
   self->priv->keyed_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                   g_free, cogl_object_unref);
+                                                   g_free, cache_entry_free);
+  g_queue_init (&self->priv->lru);
+  self->priv->max_bytes = DEFAULT_MAX_BYTES;
   self->priv->outstanding_requests = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                             g_free, NULL);
   self->priv->file_monitors = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
                                                      g_object_unref, g_object_unref);
 
+  path = g_build_filename (g_get_user_cache_dir (), "gnome-shell", "icons", NULL);
+  self->priv->icon_cache = st_icon_cache_new (path);
+  g_free (path);
+
+  self->priv->loader_pool = g_thread_pool_new (loader_pool_run, NULL,
+                                               MAX_RUNNING_LOADS, FALSE, NULL);
+  g_queue_init (&self->priv->pending_loads);
+
 }
 
 static void
 st_texture_cache_dispose (GObject *object)
 {
   StTextureCache *self = (StTextureCache*)object;
+  GTask *task;
+
+  if (self->priv->dispatch_id)
+    {
+      g_source_remove (self->priv->dispatch_id);
+      self->priv->dispatch_id = 0;
+    }
+
+  while ((task = g_queue_pop_head (&self->priv->pending_loads)))
+    {
+      texture_load_data_free (g_task_get_task_data (task));
+      g_object_unref (task);
+    }
+
+  if (self->priv->loader_pool)
+    {
+      g_thread_pool_free (self->priv->loader_pool, FALSE, TRUE);
+      self->priv->loader_pool = NULL;
+    }
 
   if (self->priv->icon_theme)
     {
@@ -168,6 +428,7 @@ st_texture_cache_dispose (GObject *object)
   g_clear_pointer (&self->priv->keyed_cache, g_hash_table_destroy);
   g_clear_pointer (&self->priv->outstanding_requests, g_hash_table_destroy);
   g_clear_pointer (&self->priv->file_monitors, g_hash_table_destroy);
+  g_clear_pointer (&self->priv->icon_cache, st_icon_cache_free);
 
   G_OBJECT_CLASS (st_texture_cache_parent_class)->dispose (object);
 }
@@ -178,6 +439,46 @@ st_texture_cache_finalize (GObject *object)
   G_OBJECT_CLASS (st_texture_cache_parent_class)->finalize (object);
 }
 
+static void
+st_texture_cache_set_property (GObject      *object,
+                               guint         prop_id,
+                               const GValue *value,
+                               GParamSpec   *pspec)
+{
+  StTextureCache *cache = ST_TEXTURE_CACHE (object);
+
+  switch (prop_id)
+    {
+    case PROP_MAX_BYTES:
+      st_texture_cache_set_max_bytes (cache, g_value_get_uint64 (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+st_texture_cache_get_property (GObject    *object,
+                               guint       prop_id,
+                               GValue     *value,
+                               GParamSpec *pspec)
+{
+  StTextureCache *cache = ST_TEXTURE_CACHE (object);
+
+  switch (prop_id)
+    {
+    case PROP_MAX_BYTES:
+      g_value_set_uint64 (value, cache->priv->max_bytes);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
 static void
 compute_pixbuf_scale (gint      width,
                       gint      height,
@@ -261,20 +562,30 @@ typedef struct {
   StTextureCachePolicy policy;
   char *key;
 
+  /* Source of the icon for the disk cache, NULL if not cached on disk */
+  char *disk_key;
+
   guint width;
   guint height;
   guint scale;
   GSList *textures;
 
+  /* Cancelled once every texture was destroyed */
+  GCancellable *cancellable;
+
   GtkIconInfo *icon_info;
   StIconColors *colors;
   GFile *file;
 } AsyncTextureLoadData;
 
+static void on_request_texture_destroyed (ClutterActor         *texture,
+                                          AsyncTextureLoadData *data);
+
 static void
 texture_load_data_free (gpointer p)
 {
   AsyncTextureLoadData *data = p;
+  GSList *iter;
 
   if (data->icon_info)
     {
@@ -288,12 +599,45 @@ texture_load_data_free (gpointer p)
   if (data->key)
     g_free (data->key);
 
-  if (data->textures)
-    g_slist_free_full (data->textures, (GDestroyNotify) g_object_unref);
+  g_free (data->disk_key);
+
+  for (iter = data->textures; iter; iter = iter->next)
+    {
+      g_signal_handlers_disconnect_by_func (iter->data,
+                                            on_request_texture_destroyed,
+                                            data);
+      g_object_unref (iter->data);
+    }
+  g_slist_free (data->textures);
+
+  g_clear_object (&data->cancellable);
 
   g_free (data);
 }
 
+/* Nobody waits for the load anymore once all the textures are gone */
+static void
+on_request_texture_destroyed (ClutterActor         *texture,
+                              AsyncTextureLoadData *data)
+{
+  StTextureCachePrivate *priv = data->cache->priv;
+
+  g_signal_handlers_disconnect_by_func (texture,
+                                        on_request_texture_destroyed,
+                                        data);
+  data->textures = g_slist_remove (data->textures, texture);
+  g_object_unref (texture);
+
+  if (data->textures != NULL)
+    return;
+
+  /* A new request for the key must start a new load */
+  if (g_hash_table_lookup (priv->outstanding_requests, data->key) == data)
+    g_hash_table_remove (priv->outstanding_requests, data->key);
+
+  g_cancellable_cancel (data->cancellable);
+}
+
 /**
  * on_image_size_prepared:
  * @pixbuf_loader: #GdkPixbufLoader loading the image
@@ -504,42 +848,39 @@ pixbuf_to_cairo_surface (GdkPixbuf *pixbuf)
   return surface;
 }
 
+/* Takes ownership of texdata */
 static void
-finish_texture_load (AsyncTextureLoadData *data,
-                     GdkPixbuf            *pixbuf)
+finish_texture_load_cogl (AsyncTextureLoadData *data,
+                          CoglTexture          *texdata)
 {
   GSList *iter;
   StTextureCache *cache;
-  CoglTexture *texdata = NULL;
 
   cache = data->cache;
 
-  g_hash_table_remove (cache->priv->outstanding_requests, data->key);
+  if (g_hash_table_lookup (cache->priv->outstanding_requests, data->key) == data)
+    g_hash_table_remove (cache->priv->outstanding_requests, data->key);
 
-  if (pixbuf == NULL)
+  if (texdata == NULL)
     goto out;
 
-  texdata = pixbuf_to_cogl_texture (pixbuf);
-
-  if (data->policy != ST_TEXTURE_CACHE_POLICY_NONE)
-    {
-      gpointer orig_key, value;
-
-      if (!g_hash_table_lookup_extended (cache->priv->keyed_cache, data->key,
-                                         &orig_key, &value))
-        {
-          cogl_object_ref (texdata);
-          g_hash_table_insert (cache->priv->keyed_cache, g_strdup (data->key),
-                               texdata);
-        }
-    }
-
   for (iter = data->textures; iter; iter = iter->next)
     {
       ClutterTexture *texture = iter->data;
       set_texture_cogl_texture (texture, texdata);
     }
 
+  if (data->policy != ST_TEXTURE_CACHE_POLICY_NONE &&
+      !g_hash_table_contains (cache->priv->keyed_cache, data->key))
+    {
+      StTextureCacheEntry *entry;
+
+      entry = keyed_cache_insert (cache, data->key, cogl_object_ref (texdata), FALSE, FALSE);
+      for (iter = data->textures; iter; iter = iter->next)
+        cache_entry_bind (entry, iter->data);
+      keyed_cache_trim (cache);
+    }
+
 out:
   if (texdata)
     cogl_object_unref (texdata);
@@ -547,6 +888,149 @@ out:
   texture_load_data_free (data);
 }
 
+static void
+finish_texture_load (AsyncTextureLoadData *data,
+                     GdkPixbuf            *pixbuf)
+{
+  CoglTexture *texdata = NULL;
+
+  if (pixbuf != NULL)
+    {
+      texdata = pixbuf_to_cogl_texture (pixbuf);
+
+      if (data->disk_key)
+        st_icon_cache_store (data->cache->priv->icon_cache,
+                             data->key, data->disk_key, pixbuf);
+    }
+
+  finish_texture_load_cogl (data, texdata);
+}
+
+static void load_texture_async (StTextureCache       *cache,
+                                AsyncTextureLoadData *data);
+
+/* A lookup in the disk cache, the source file of the icon is stat()ed and
+ * the cache file mapped in a worker thread */
+typedef struct {
+  char *key;
+  char *filename;
+  char *theme_name;
+
+  /* results */
+  char *disk_key;
+  GBytes *pixels;
+  int width;
+  int height;
+  int rowstride;
+} DiskCacheLookup;
+
+static void
+disk_cache_lookup_free (gpointer p)
+{
+  DiskCacheLookup *lookup = p;
+
+  g_free (lookup->key);
+  g_free (lookup->filename);
+  g_free (lookup->theme_name);
+  g_free (lookup->disk_key);
+  if (lookup->pixels)
+    g_bytes_unref (lookup->pixels);
+  g_free (lookup);
+}
+
+static void
+disk_cache_lookup_thread (GTask        *task,
+                          gpointer      source,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+  StTextureCache *cache = source;
+  DiskCacheLookup *lookup = task_data;
+  GStatBuf buf;
+
+  /* the key describes the file the icon is loaded from */
+  if (g_stat (lookup->filename, &buf) == 0)
+    {
+      lookup->disk_key = g_strdup_printf ("%s,theme=%s,mtime=%" G_GINT64_FORMAT,
+                                          lookup->filename,
+                                          lookup->theme_name ? lookup->theme_name : "",
+                                          (gint64) buf.st_mtime);
+      lookup->pixels = st_icon_cache_lookup (cache->priv->icon_cache, lookup->key,
+                                             lookup->disk_key, &lookup->width,
+                                             &lookup->height, &lookup->rowstride);
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+/* Completes the request from the disk cache without decoding anything, or
+ * starts the decoding */
+static void
+on_disk_cache_lookup_done (GObject      *source,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+  StTextureCache *cache = ST_TEXTURE_CACHE (source);
+  AsyncTextureLoadData *data = user_data;
+  DiskCacheLookup *lookup = g_task_get_task_data (G_TASK (result));
+  ClutterBackend *backend;
+  CoglContext *ctx;
+  CoglTexture2D *texture;
+
+  /* every texture of the request was destroyed */
+  if (!g_task_propagate_boolean (G_TASK (result), NULL))
+    {
+      finish_texture_load_cogl (data, NULL);
+      return;
+    }
+
+  /* a miss is decoded, then stored if the icon comes from a file */
+  data->disk_key = lookup->disk_key;
+  lookup->disk_key = NULL;
+
+  if (lookup->pixels == NULL)
+    {
+      load_texture_async (cache, data);
+      return;
+    }
+
+  backend = clutter_get_default_backend ();
+  ctx = clutter_backend_get_cogl_context (backend);
+  texture = cogl_texture_2d_new_from_data (ctx, lookup->width, lookup->height,
+                                           COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                           lookup->rowstride,
+                                           g_bytes_get_data (lookup->pixels, NULL),
+                                           NULL);
+
+  if (texture == NULL)
+    load_texture_async (cache, data);
+  else
+    finish_texture_load_cogl (data, COGL_TEXTURE (texture));
+}
+
+/* Looks the icon of data up in the disk cache before decoding it */
+static void
+load_texture_from_disk_cache_async (StTextureCache       *cache,
+                                    AsyncTextureLoadData *data)
+{
+  DiskCacheLookup *lookup;
+  GtkSettings *settings;
+  GTask *task;
+
+  lookup = g_new0 (DiskCacheLookup, 1);
+  lookup->key = g_strdup (data->key);
+  lookup->filename = g_strdup (gtk_icon_info_get_filename (data->icon_info));
+
+  settings = gtk_settings_get_default ();
+  if (settings)
+    g_object_get (settings, "gtk-icon-theme-name", &lookup->theme_name, NULL);
+
+  task = g_task_new (cache, data->cancellable, on_disk_cache_lookup_done, data);
+  g_task_set_task_data (task, lookup, disk_cache_lookup_free);
+  g_task_run_in_thread (task, disk_cache_lookup_thread);
+  g_object_unref (task);
+}
+
 static void
 on_symbolic_icon_loaded (GObject      *source,
                          GAsyncResult *result,
@@ -569,15 +1053,101 @@ on_icon_loaded (GObject      *source,
   g_clear_object (&pixbuf);
 }
 
+static void dispatch_pending_loads (StTextureCache *cache);
+
 static void
 on_pixbuf_loaded (GObject      *source,
                   GAsyncResult *result,
                   gpointer      user_data)
 {
+  StTextureCache *cache = ST_TEXTURE_CACHE (source);
   GdkPixbuf *pixbuf;
-  pixbuf = load_pixbuf_async_finish (ST_TEXTURE_CACHE (source), result, NULL);
+
+  pixbuf = load_pixbuf_async_finish (cache, result, NULL);
   finish_texture_load (user_data, pixbuf);
   g_clear_object (&pixbuf);
+
+  cache->priv->n_running_loads--;
+  dispatch_pending_loads (cache);
+}
+
+static void
+loader_pool_run (gpointer task,
+                 gpointer user_data)
+{
+  if (!g_task_return_error_if_cancelled (task))
+    load_pixbuf_thread (task,
+                        g_task_get_source_object (task),
+                        g_task_get_task_data (task),
+                        g_task_get_cancellable (task));
+  g_object_unref (task);
+}
+
+static gboolean
+request_is_visible (AsyncTextureLoadData *data)
+{
+  GSList *iter;
+
+  for (iter = data->textures; iter; iter = iter->next)
+    {
+      if (clutter_actor_is_mapped (iter->data))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Feeds loader_pool, loads for mapped textures first, then prefetches in
+ * request order. The choice is made when a thread is free rather than
+ * when the load is requested, as textures are usually not mapped yet
+ * when they are created.
+ */
+static void
+dispatch_pending_loads (StTextureCache *cache)
+{
+  StTextureCachePrivate *priv = cache->priv;
+
+  while (priv->n_running_loads < MAX_RUNNING_LOADS &&
+         !g_queue_is_empty (&priv->pending_loads))
+    {
+      GList *next = NULL;
+      GList *l;
+      GTask *task;
+
+      for (l = priv->pending_loads.head; l; l = l->next)
+        {
+          if (request_is_visible (g_task_get_task_data (l->data)))
+            {
+              next = l;
+              break;
+            }
+        }
+
+      if (next == NULL)
+        next = priv->pending_loads.head;
+
+      task = next->data;
+      g_queue_delete_link (&priv->pending_loads, next);
+
+      /* on_pixbuf_loaded() is called for cancelled loads too */
+      priv->n_running_loads++;
+
+      if (g_task_return_error_if_cancelled (task))
+        g_object_unref (task);
+      else
+        g_thread_pool_push (priv->loader_pool, task, NULL);
+    }
+}
+
+static gboolean
+dispatch_pending_loads_idle (gpointer user_data)
+{
+  StTextureCache *cache = user_data;
+
+  cache->priv->dispatch_id = 0;
+  dispatch_pending_loads (cache);
+
+  return G_SOURCE_REMOVE;
 }
 
 static void
@@ -586,10 +1156,13 @@ load_texture_async (StTextureCache       *cache,
 {
   if (data->file)
     {
-      GTask *task = g_task_new (cache, NULL, on_pixbuf_loaded, data);
+      GTask *task = g_task_new (cache, data->cancellable, on_pixbuf_loaded, data);
       g_task_set_task_data (task, data, NULL);
-      g_task_run_in_thread (task, load_pixbuf_thread);
-      g_object_unref (task);
+
+      /* Dispatched once the caller had a chance to show the texture */
+      g_queue_push_tail (&cache->priv->pending_loads, task);
+      if (cache->priv->dispatch_id == 0)
+        cache->priv->dispatch_id = g_idle_add (dispatch_pending_loads_idle, cache);
     }
   else if (data->icon_info)
     {
@@ -609,11 +1182,11 @@ load_texture_async (StTextureCache       *cache,
           gtk_icon_info_load_symbolic_async (data->icon_info,
                                              &foreground_color, &success_color,
                                              &warning_color, &error_color,
-                                             NULL, on_symbolic_icon_loaded, data);
+                                             data->cancellable, on_symbolic_icon_loaded, data);
         }
       else
         {
-          gtk_icon_info_load_icon_async (data->icon_info, NULL, on_icon_loaded, data);
+          gtk_icon_info_load_icon_async (data->icon_info, data->cancellable, on_icon_loaded, data);
         }
     }
   else
@@ -766,20 +1339,26 @@ st_texture_cache_load (StTextureCache       *cache,
                        void                 *data,
                        GError              **error)
 {
+  StTextureCacheEntry *entry;
   CoglTexture *texture;
 
-  texture = g_hash_table_lookup (cache->priv->keyed_cache, key);
-  if (!texture)
+  entry = keyed_cache_lookup (cache, key);
+  if (!entry)
     {
       texture = load (cache, key, data, error);
       if (texture)
-        g_hash_table_insert (cache->priv->keyed_cache, g_strdup (key), texture);
+        {
+          /* Never set on an actor by the cache, thus never seen unused */
+          cogl_object_ref (texture);
+          keyed_cache_insert (cache, key, texture, FALSE, TRUE);
+          keyed_cache_trim (cache);
+          return texture;
+        }
       else
         return NULL;
     }
 
-  cogl_object_ref (texture);
-  return texture;
+  return cogl_object_ref (entry->data);
 }
 
 /**
@@ -803,16 +1382,17 @@ ensure_request (StTextureCache        *cache,
                 AsyncTextureLoadData **request,
                 ClutterActor          *texture)
 {
-  CoglTexture *texdata;
+  StTextureCacheEntry *entry;
   AsyncTextureLoadData *pending;
   gboolean had_pending;
 
-  texdata = g_hash_table_lookup (cache->priv->keyed_cache, key);
+  entry = keyed_cache_lookup (cache, key);
 
-  if (texdata != NULL)
+  if (entry != NULL)
     {
       /* We had this cached already, just set the texture and we're done. */
-      set_texture_cogl_texture (CLUTTER_TEXTURE (texture), texdata);
+      set_texture_cogl_texture (CLUTTER_TEXTURE (texture), entry->data);
+      cache_entry_bind (entry, CLUTTER_TEXTURE (texture));
       return TRUE;
     }
 
@@ -823,6 +1403,8 @@ ensure_request (StTextureCache        *cache,
     {
       /* Not cached and no pending request, create it */
       *request = g_new0 (AsyncTextureLoadData, 1);
+      (*request)->cache = cache;
+      (*request)->cancellable = g_cancellable_new ();
       if (policy != ST_TEXTURE_CACHE_POLICY_NONE)
         g_hash_table_insert (cache->priv->outstanding_requests, g_strdup (key), *request);
     }
@@ -831,6 +1413,8 @@ ensure_request (StTextureCache        *cache,
 
   /* Regardless of whether there was a pending request, prepend our texture here. */
   (*request)->textures = g_slist_prepend ((*request)->textures, g_object_ref (texture));
+  g_signal_connect (texture, "destroy",
+                    G_CALLBACK (on_request_texture_destroyed), *request);
 
   return had_pending;
 }
@@ -939,7 +1523,12 @@ st_texture_cache_load_gicon (StTextureCache    *cache,
       request->width = request->height = size;
       request->scale = scale;
 
-      load_texture_async (cache, request);
+      /* Icons without a file, such as builtin icons, are not cached on disk */
+      if (policy != ST_TEXTURE_CACHE_POLICY_NONE &&
+          gtk_icon_info_get_filename (info) != NULL)
+        load_texture_from_disk_cache_async (cache, request);
+      else
+        load_texture_async (cache, request);
     }
 
   return CLUTTER_ACTOR (texture);
@@ -1256,15 +1845,16 @@ st_texture_cache_load_file_sync_to_cogl_texture (StTextureCache *cache,
                                                  int             scale,
                                                  GError         **error)
 {
-  CoglTexture *texdata;
+  StTextureCacheEntry *entry;
+  CoglTexture *texdata = NULL;
   GdkPixbuf *pixbuf;
   char *key;
 
   key = g_strdup_printf (CACHE_PREFIX_FILE "%u", g_file_hash (file));
 
-  texdata = g_hash_table_lookup (cache->priv->keyed_cache, key);
+  entry = keyed_cache_lookup (cache, key);
 
-  if (texdata == NULL)
+  if (entry == NULL)
     {
       pixbuf = impl_load_pixbuf_file (file, available_width, available_height, scale, error);
       if (!pixbuf)
@@ -1273,14 +1863,15 @@ st_texture_cache_load_file_sync_to_cogl_texture (StTextureCache *cache,
       texdata = pixbuf_to_cogl_texture (pixbuf);
       g_object_unref (pixbuf);
 
+      /* Callers keep the texture without an actor, pin it */
       if (policy == ST_TEXTURE_CACHE_POLICY_FOREVER)
         {
-          cogl_object_ref (texdata);
-          g_hash_table_insert (cache->priv->keyed_cache, g_strdup (key), texdata);
+          keyed_cache_insert (cache, key, cogl_object_ref (texdata), FALSE, TRUE);
+          keyed_cache_trim (cache);
         }
     }
   else
-    cogl_object_ref (texdata);
+    texdata = cogl_object_ref (entry->data);
 
   ensure_monitor_for_file (cache, file);
 
@@ -1298,15 +1889,16 @@ st_texture_cache_load_file_sync_to_cairo_surface (StTextureCache        *cache,
                                                   int                    scale,
                                                   GError               **error)
 {
-  cairo_surface_t *surface;
+  StTextureCacheEntry *entry;
+  cairo_surface_t *surface = NULL;
   GdkPixbuf *pixbuf;
   char *key;
 
   key = g_strdup_printf (CACHE_PREFIX_FILE_FOR_CAIRO "%u", g_file_hash (file));
 
-  surface = g_hash_table_lookup (cache->priv->keyed_cache, key);
+  entry = keyed_cache_lookup (cache, key);
 
-  if (surface == NULL)
+  if (entry == NULL)
     {
       pixbuf = impl_load_pixbuf_file (file, available_width, available_height, scale, error);
       if (!pixbuf)
@@ -1315,14 +1907,15 @@ st_texture_cache_load_file_sync_to_cairo_surface (StTextureCache        *cache,
       surface = pixbuf_to_cairo_surface (pixbuf);
       g_object_unref (pixbuf);
 
+      /* POLICY_FOREVER keeps the surface even once callers drop it */
       if (policy == ST_TEXTURE_CACHE_POLICY_FOREVER)
         {
-          cairo_surface_reference (surface);
-          g_hash_table_insert (cache->priv->keyed_cache, g_strdup (key), surface);
+          keyed_cache_insert (cache, key, cairo_surface_reference (surface), TRUE, TRUE);
+          keyed_cache_trim (cache);
         }
     }
   else
-    cairo_surface_reference (surface);
+    surface = cairo_surface_reference (entry->data);
 
   ensure_monitor_for_file (cache, file);
 
@@ -1413,3 +2006,76 @@ st_texture_cache_get_default (void)
     instance = g_object_new (ST_TYPE_TEXTURE_CACHE, NULL);
   return instance;
 }
+
+/**
+ * st_texture_cache_set_max_bytes:
+ * @cache: A #StTextureCache
+ * @max_bytes: Size of the cache before eviction, in bytes
+ *
+ * Sets #StTextureCache:max-bytes, evicting textures as needed.
+ */
+void
+st_texture_cache_set_max_bytes (StTextureCache *cache,
+                                guint64         max_bytes)
+{
+  g_return_if_fail (ST_IS_TEXTURE_CACHE (cache));
+
+  if (cache->priv->max_bytes == max_bytes)
+    return;
+
+  cache->priv->max_bytes = max_bytes;
+  keyed_cache_trim (cache);
+  g_object_notify (G_OBJECT (cache), "max-bytes");
+}
+
+/**
+ * st_texture_cache_get_max_bytes:
+ * @cache: A #StTextureCache
+ *
+ * Returns: the value of #StTextureCache:max-bytes
+ */
+guint64
+st_texture_cache_get_max_bytes (StTextureCache *cache)
+{
+  g_return_val_if_fail (ST_IS_TEXTURE_CACHE (cache), 0);
+
+  return cache->priv->max_bytes;
+}
+
+/**
+ * st_texture_cache_get_statistics:
+ * @cache: A #StTextureCache
+ * @n_bytes: (out) (optional): Estimated size of the cached textures
+ * @n_entries: (out) (optional): Number of cached textures
+ * @n_hits: (out) (optional): Lookups that found a cached texture
+ * @n_misses: (out) (optional): Lookups that had to load the texture
+ * @n_evictions: (out) (optional): Textures evicted to fit in
+ *   #StTextureCache:max-bytes
+ *
+ * Gets counters of the cache since its creation, for performance logs.
+ */
+void
+st_texture_cache_get_statistics (StTextureCache *cache,
+                                 guint64        *n_bytes,
+                                 guint          *n_entries,
+                                 guint          *n_hits,
+                                 guint          *n_misses,
+                                 guint          *n_evictions)
+{
+  StTextureCachePrivate *priv;
+
+  g_return_if_fail (ST_IS_TEXTURE_CACHE (cache));
+
+  priv = cache->priv;
+
+  if (n_bytes)
+    *n_bytes = priv->n_bytes;
+  if (n_entries)
+    *n_entries = g_hash_table_size (priv->keyed_cache);
+  if (n_hits)
+    *n_hits = priv->n_hits;
+  if (n_misses)
+    *n_misses = priv->n_misses;
+  if (n_evictions)
+    *n_evictions = priv->n_evictions;
+}
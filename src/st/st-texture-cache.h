@@ -53,6 +53,17 @@ typedef enum {
 
 StTextureCache* st_texture_cache_get_default (void);
 
+void    st_texture_cache_set_max_bytes  (StTextureCache *cache,
+                                         guint64         max_bytes);
+guint64 st_texture_cache_get_max_bytes  (StTextureCache *cache);
+
+void    st_texture_cache_get_statistics (StTextureCache *cache,
+                                         guint64        *n_bytes,
+                                         guint          *n_entries,
+                                         guint          *n_hits,
+                                         guint          *n_misses,
+                                         guint          *n_evictions);
+
 ClutterActor *
 st_texture_cache_load_sliced_image (StTextureCache *cache,
                                     GFile          *file,
@@ -26,6 +26,7 @@
 
 #include "st-theme-node.h"
 #include <libcroco/libcroco.h>
+#include "st-theme-private.h"
 #include "st-types.h"
 
 G_BEGIN_DECLS
@@ -83,6 +84,9 @@ struct _StThemeNode {
   GStrv pseudo_classes;
   char *inline_style;
 
+  /* properties borrows the declarations of match, unless the node has an
+   * inline style */
+  StThemeMatch *match;
   CRDeclaration **properties;
   int n_properties;
 
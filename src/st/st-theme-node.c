@@ -71,11 +71,18 @@ maybe_free_properties (StThemeNode *node)
 {
   if (node->properties)
     {
-      g_free (node->properties);
+      if (node->match == NULL || node->properties != node->match->properties)
+        g_free (node->properties);
       node->properties = NULL;
       node->n_properties = 0;
     }
 
+  if (node->match)
+    {
+      _st_theme_match_unref (node->match);
+      node->match = NULL;
+    }
+
   if (node->inline_properties)
     {
       /* This destroys the list, not just the head of the list */
@@ -470,35 +477,54 @@ st_theme_node_hash (StThemeNode *node)
   return hash;
 }
 
+static StThemeMatch *
+ensure_match (StThemeNode *node)
+{
+  if (node->match == NULL && node->theme != NULL)
+    {
+      StThemeMatch *parent_match = NULL;
+
+      if (node->parent_node)
+        parent_match = ensure_match (node->parent_node);
+
+      node->match = _st_theme_match_node (node->theme, node, parent_match);
+    }
+
+  return node->match;
+}
+
 static void
 ensure_properties (StThemeNode *node)
 {
   if (!node->properties_computed)
     {
-      GPtrArray *properties = NULL;
+      StThemeMatch *match;
 
       node->properties_computed = TRUE;
 
-      if (node->theme)
-        properties = _st_theme_get_matched_properties (node->theme, node);
+      match = ensure_match (node);
 
       if (node->inline_style)
         {
+          GPtrArray *properties = g_ptr_array_new ();
           CRDeclaration *cur_decl;
+          int i;
 
-          if (!properties)
-            properties = g_ptr_array_new ();
+          for (i = 0; match && i < match->n_properties; i++)
+            g_ptr_array_add (properties, match->properties[i]);
 
           node->inline_properties = _st_theme_parse_declaration_list (node->inline_style);
           for (cur_decl = node->inline_properties; cur_decl; cur_decl = cur_decl->next)
             g_ptr_array_add (properties, cur_decl);
-        }
 
-      if (properties)
-        {
           node->n_properties = properties->len;
           node->properties = (CRDeclaration **)g_ptr_array_free (properties, FALSE);
         }
+      else if (match)
+        {
+          node->n_properties = match->n_properties;
+          node->properties = match->properties;
+        }
     }
 }
 
@@ -29,6 +29,35 @@ G_BEGIN_DECLS
 GPtrArray *_st_theme_get_matched_properties (StTheme       *theme,
                                              StThemeNode   *node);
 
+typedef struct _StThemeMatch StThemeMatch;
+
+/* The sorted declarations matched by a node. Nodes with the same element
+ * type, id, classes and pseudo-classes, whose parents share a match, share
+ * it too, until the stylesheets of the theme change.
+ */
+struct _StThemeMatch {
+  int ref_count;
+
+  StTheme *theme;
+  guint generation;
+  guint hash;
+
+  StThemeMatch *parent;
+  GType element_type;
+  char *element_id;
+  GStrv element_classes;
+  GStrv pseudo_classes;
+
+  CRDeclaration **properties;
+  int n_properties;
+};
+
+StThemeMatch *_st_theme_match_node   (StTheme      *theme,
+                                      StThemeNode  *node,
+                                      StThemeMatch *parent_match);
+StThemeMatch *_st_theme_match_ref    (StThemeMatch *match);
+void          _st_theme_match_unref  (StThemeMatch *match);
+
 /* Resolve an URL from the stylesheet to a file */
 GFile *_st_theme_resolve_url (StTheme      *theme,
                               CRStyleSheet *base_stylesheet,
@@ -67,10 +67,35 @@ struct _StTheme
 
   GHashTable *stylesheets_by_file;
   GHashTable *files_by_stylesheet;
+  GHashTable *rule_indexes;
+
+  /* set of StThemeMatch, emptied when generation changes */
+  GHashTable *matches;
+  guint generation;
 
   CRCascade *cascade;
 };
 
+/* A selector of a stylesheet, or an @import rule when sel is NULL */
+typedef struct {
+  CRStatement *stmt;
+  CRSelector  *sel;
+} StThemeRule;
+
+/* Rules of a stylesheet bucketed by a necessary condition on the rightmost
+ * simple selector: its id, else its first class, else its element type.
+ * A node can only match the rules of its own buckets and the rules with no
+ * such condition. Buckets hold positions in rules, which is in document
+ * order.
+ */
+typedef struct {
+  GArray *rules;
+  GHashTable *by_id;
+  GHashTable *by_class;
+  GHashTable *by_type;
+  GArray *always;
+} StThemeRuleIndex;
+
 enum
 {
   PROP_0,
@@ -106,12 +131,172 @@ file_equal0 (GFile *file1,
   return g_file_equal (file1, file2);
 }
 
+static void
+rule_bucket_add (GHashTable *buckets,
+                 const char *key,
+                 guint       position)
+{
+  GArray *bucket;
+
+  bucket = g_hash_table_lookup (buckets, key);
+  if (bucket == NULL)
+    {
+      bucket = g_array_new (FALSE, FALSE, sizeof (guint));
+      g_hash_table_insert (buckets, (gpointer) key, bucket);
+    }
+
+  g_array_append_val (bucket, position);
+}
+
+static void
+rule_index_add (StThemeRuleIndex *rule_index,
+                CRStatement      *stmt,
+                CRSelector       *sel)
+{
+  StThemeRule rule = { stmt, sel };
+  CRSimpleSel *last;
+  CRAdditionalSel *add_sel;
+  const char *class_name = NULL;
+  guint position = rule_index->rules->len;
+
+  g_array_append_val (rule_index->rules, rule);
+
+  if (sel == NULL)
+    {
+      g_array_append_val (rule_index->always, position);
+      return;
+    }
+
+  for (last = sel->simple_sel; last->next; last = last->next)
+    ;
+
+  for (add_sel = last->add_sel; add_sel; add_sel = add_sel->next)
+    {
+      if (add_sel->type == ID_ADD_SELECTOR
+          && add_sel->content.id_name
+          && add_sel->content.id_name->stryng
+          && add_sel->content.id_name->stryng->str)
+        {
+          rule_bucket_add (rule_index->by_id, add_sel->content.id_name->stryng->str, position);
+          return;
+        }
+
+      if (class_name == NULL
+          && add_sel->type == CLASS_ADD_SELECTOR
+          && add_sel->content.class_name
+          && add_sel->content.class_name->stryng
+          && add_sel->content.class_name->stryng->str)
+        class_name = add_sel->content.class_name->stryng->str;
+    }
+
+  if (class_name)
+    rule_bucket_add (rule_index->by_class, class_name, position);
+  else if ((last->type_mask & TYPE_SELECTOR)
+           && !(last->type_mask & UNIVERSAL_SELECTOR)
+           && last->name
+           && last->name->stryng
+           && last->name->stryng->str)
+    rule_bucket_add (rule_index->by_type, last->name->stryng->str, position);
+  else
+    g_array_append_val (rule_index->always, position);
+}
+
+/* Keys are borrowed from the stylesheet, which outlives its index */
+static StThemeRuleIndex *
+rule_index_new (CRStyleSheet *stylesheet)
+{
+  StThemeRuleIndex *rule_index = g_new0 (StThemeRuleIndex, 1);
+  CRStatement *cur_stmt;
+  CRSelector *sel_list;
+  CRSelector *cur_sel;
+
+  rule_index->rules = g_array_new (FALSE, FALSE, sizeof (StThemeRule));
+  rule_index->by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                        NULL, (GDestroyNotify)g_array_unref);
+  rule_index->by_class = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           NULL, (GDestroyNotify)g_array_unref);
+  rule_index->by_type = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          NULL, (GDestroyNotify)g_array_unref);
+  rule_index->always = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  for (cur_stmt = stylesheet->statements; cur_stmt; cur_stmt = cur_stmt->next)
+    {
+      sel_list = NULL;
+
+      switch (cur_stmt->type)
+        {
+        case RULESET_STMT:
+          if (cur_stmt->kind.ruleset && cur_stmt->kind.ruleset->sel_list)
+            sel_list = cur_stmt->kind.ruleset->sel_list;
+          break;
+
+        case AT_MEDIA_RULE_STMT:
+          if (cur_stmt->kind.media_rule
+              && cur_stmt->kind.media_rule->rulesets
+              && cur_stmt->kind.media_rule->rulesets->kind.ruleset
+              && cur_stmt->kind.media_rule->rulesets->kind.ruleset->sel_list)
+            sel_list = cur_stmt->kind.media_rule->rulesets->kind.ruleset->sel_list;
+          break;
+
+        case AT_IMPORT_RULE_STMT:
+          rule_index_add (rule_index, cur_stmt, NULL);
+          break;
+
+        default:
+          break;
+        }
+
+      for (cur_sel = sel_list; cur_sel; cur_sel = cur_sel->next)
+        {
+          if (cur_sel->simple_sel)
+            rule_index_add (rule_index, cur_stmt, cur_sel);
+        }
+    }
+
+  return rule_index;
+}
+
+static void
+rule_index_free (StThemeRuleIndex *rule_index)
+{
+  g_array_unref (rule_index->rules);
+  g_hash_table_destroy (rule_index->by_id);
+  g_hash_table_destroy (rule_index->by_class);
+  g_hash_table_destroy (rule_index->by_type);
+  g_array_unref (rule_index->always);
+  g_free (rule_index);
+}
+
+static StThemeRuleIndex *
+get_rule_index (StTheme      *theme,
+                CRStyleSheet *stylesheet)
+{
+  StThemeRuleIndex *rule_index;
+
+  rule_index = g_hash_table_lookup (theme->rule_indexes, stylesheet);
+  if (rule_index == NULL)
+    {
+      rule_index = rule_index_new (stylesheet);
+      g_hash_table_insert (theme->rule_indexes, stylesheet, rule_index);
+    }
+
+  return rule_index;
+}
+
+static guint    match_hash  (gconstpointer key);
+static gboolean match_equal (gconstpointer a,
+                             gconstpointer b);
+
 static void
 st_theme_init (StTheme *theme)
 {
   theme->stylesheets_by_file = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
                                                       (GDestroyNotify)g_object_unref, (GDestroyNotify)cr_stylesheet_unref);
   theme->files_by_stylesheet = g_hash_table_new (g_direct_hash, g_direct_equal);
+  theme->rule_indexes = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                               NULL, (GDestroyNotify)rule_index_free);
+  theme->matches = g_hash_table_new_full (match_hash, match_equal,
+                                          (GDestroyNotify)_st_theme_match_unref, NULL);
 }
 
 static void
@@ -247,6 +432,19 @@ insert_stylesheet (StTheme      *theme,
 
   g_hash_table_insert (theme->stylesheets_by_file, file, stylesheet);
   g_hash_table_insert (theme->files_by_stylesheet, stylesheet, file);
+
+  get_rule_index (theme, stylesheet);
+}
+
+static void
+custom_stylesheets_changed (StTheme *theme)
+{
+  /* matches of the previous generation stay valid for the nodes
+   * holding them, but are no longer shared */
+  theme->generation++;
+  g_hash_table_remove_all (theme->matches);
+
+  g_signal_emit (theme, signals[STYLESHEETS_CHANGED], 0);
 }
 
 gboolean
@@ -265,7 +463,7 @@ st_theme_load_stylesheet (StTheme    *theme,
   insert_stylesheet (theme, file, stylesheet);
   cr_stylesheet_ref (stylesheet);
   theme->custom_stylesheets = g_slist_prepend (theme->custom_stylesheets, stylesheet);
-  g_signal_emit (theme, signals[STYLESHEETS_CHANGED], 0);
+  custom_stylesheets_changed (theme);
 
   return TRUE;
 }
@@ -286,8 +484,9 @@ st_theme_unload_stylesheet (StTheme    *theme,
   theme->custom_stylesheets = g_slist_remove (theme->custom_stylesheets, stylesheet);
   g_hash_table_remove (theme->stylesheets_by_file, file);
   g_hash_table_remove (theme->files_by_stylesheet, stylesheet);
+  g_hash_table_remove (theme->rule_indexes, stylesheet);
   cr_stylesheet_unref (stylesheet);
-  g_signal_emit (theme, signals[STYLESHEETS_CHANGED], 0);
+  custom_stylesheets_changed (theme);
 }
 
 /**
@@ -349,6 +548,8 @@ st_theme_finalize (GObject * object)
   g_slist_free (theme->custom_stylesheets);
   theme->custom_stylesheets = NULL;
 
+  g_hash_table_destroy (theme->matches);
+  g_hash_table_destroy (theme->rule_indexes);
   g_hash_table_destroy (theme->stylesheets_by_file);
   g_hash_table_destroy (theme->files_by_stylesheet);
 
@@ -818,141 +1019,180 @@ done:
   return CR_OK;
 }
 
+static void
+add_bucket_candidates (GArray     *candidates,
+                       GHashTable *buckets,
+                       const char *key)
+{
+  GArray *bucket = g_hash_table_lookup (buckets, key);
+
+  if (bucket)
+    g_array_append_vals (candidates, bucket->data, bucket->len);
+}
+
+static int
+compare_positions (gconstpointer a,
+                   gconstpointer b)
+{
+  guint position_a = *(const guint *) a;
+  guint position_b = *(const guint *) b;
+
+  return position_a < position_b ? -1 : position_a > position_b;
+}
+
+/* Positions of the rules of @rule_index that @a_node could match, in
+ * document order, each once.
+ */
+static GArray *
+get_candidate_rules (StThemeRuleIndex *rule_index,
+                     StThemeNode      *a_node)
+{
+  GArray *candidates = g_array_new (FALSE, FALSE, sizeof (guint));
+  GType type = st_theme_node_get_element_type (a_node);
+  const char *id = st_theme_node_get_element_id (a_node);
+  GStrv classes = st_theme_node_get_element_classes (a_node);
+  guint i, j;
+
+  g_array_append_vals (candidates, rule_index->always->data, rule_index->always->len);
+
+  if (id)
+    add_bucket_candidates (candidates, rule_index->by_id, id);
+
+  for (i = 0; classes && classes[i]; i++)
+    add_bucket_candidates (candidates, rule_index->by_class, classes[i]);
+
+  /* every type name element_name_matches_type() accepts for the node */
+  if (type == G_TYPE_NONE)
+    {
+      add_bucket_candidates (candidates, rule_index->by_type, "stage");
+    }
+  else if (g_hash_table_size (rule_index->by_type) > 0)
+    {
+      GType *interfaces;
+      GType t;
+      guint n_interfaces;
+
+      for (t = type; t; t = g_type_parent (t))
+        add_bucket_candidates (candidates, rule_index->by_type, g_type_name (t));
+
+      interfaces = g_type_interfaces (type, &n_interfaces);
+      for (i = 0; i < n_interfaces; i++)
+        add_bucket_candidates (candidates, rule_index->by_type, g_type_name (interfaces[i]));
+      g_free (interfaces);
+    }
+
+  g_array_sort (candidates, compare_positions);
+
+  /* a node listing a class twice must not match its rules twice */
+  for (i = 0, j = 0; i < candidates->len; i++)
+    {
+      if (j > 0 && g_array_index (candidates, guint, i) == g_array_index (candidates, guint, j - 1))
+        continue;
+      g_array_index (candidates, guint, j++) = g_array_index (candidates, guint, i);
+    }
+  g_array_set_size (candidates, j);
+
+  return candidates;
+}
+
 static void
 add_matched_properties (StTheme      *a_this,
                         CRStyleSheet *a_nodesheet,
                         StThemeNode  *a_node,
                         GPtrArray    *props)
 {
+  StThemeRuleIndex *rule_index;
+  GArray *candidates;
   CRStatement *cur_stmt = NULL;
-  CRSelector *sel_list = NULL;
   CRSelector *cur_sel = NULL;
   gboolean matches = FALSE;
   enum CRStatus status = CR_OK;
+  guint i;
 
   /*
-   *walk through the list of statements and,
-   *get the selectors list inside the statements that
-   *contain some, and try to match our style node in these
-   *selectors lists.
+   *only look at the rules whose rightmost selector can match
+   *our style node, in the order they appear in the stylesheet,
+   *and try to match the style node on each of them.
    */
-  for (cur_stmt = a_nodesheet->statements; cur_stmt; cur_stmt = cur_stmt->next)
+  rule_index = get_rule_index (a_this, a_nodesheet);
+  candidates = get_candidate_rules (rule_index, a_node);
+
+  for (i = 0; i < candidates->len; i++)
     {
-      /*
-       *initialyze the selector list in which we will
-       *really perform the search.
-       */
-      sel_list = NULL;
+      StThemeRule *rule = &g_array_index (rule_index->rules, StThemeRule,
+                                          g_array_index (candidates, guint, i));
 
-      /*
-       *get the the damn selector list in
-       *which we have to look
-       */
-      switch (cur_stmt->type)
+      cur_stmt = rule->stmt;
+      cur_sel = rule->sel;
+
+      if (cur_sel == NULL)
         {
-        case RULESET_STMT:
-          if (cur_stmt->kind.ruleset && cur_stmt->kind.ruleset->sel_list)
+          CRAtImportRule *import_rule = cur_stmt->kind.import_rule;
+
+          if (import_rule->sheet == NULL)
             {
-              sel_list = cur_stmt->kind.ruleset->sel_list;
+              GFile *file = NULL;
+
+              if (import_rule->url->stryng && import_rule->url->stryng->str)
+                {
+                  file = _st_theme_resolve_url (a_this,
+                                                a_nodesheet,
+                                                import_rule->url->stryng->str);
+                  import_rule->sheet = parse_stylesheet (file, NULL);
+                }
+
+              if (import_rule->sheet)
+                {
+                  insert_stylesheet (a_this, file, import_rule->sheet);
+                  /* refcount of stylesheets starts off at zero, so we don't need to unref! */
+                }
+              else
+                {
+                  /* Set a marker to avoid repeatedly trying to parse a non-existent or
+                   * broken stylesheet
+                   */
+                  import_rule->sheet = (CRStyleSheet *) - 1;
+                }
+
+              if (file)
+                g_object_unref (file);
             }
-          break;
 
-        case AT_MEDIA_RULE_STMT:
-          if (cur_stmt->kind.media_rule
-              && cur_stmt->kind.media_rule->rulesets
-              && cur_stmt->kind.media_rule->rulesets->kind.ruleset
-              && cur_stmt->kind.media_rule->rulesets->kind.ruleset->sel_list)
+          if (import_rule->sheet != (CRStyleSheet *) - 1)
             {
-              sel_list = cur_stmt->kind.media_rule->rulesets->kind.ruleset->sel_list;
+              add_matched_properties (a_this, import_rule->sheet,
+                                      a_node, props);
             }
-          break;
-
-        case AT_IMPORT_RULE_STMT:
-          {
-            CRAtImportRule *import_rule = cur_stmt->kind.import_rule;
 
-            if (import_rule->sheet == NULL)
-              {
-                GFile *file = NULL;
-
-                if (import_rule->url->stryng && import_rule->url->stryng->str)
-                  {
-                    file = _st_theme_resolve_url (a_this,
-                                                  a_nodesheet,
-                                                  import_rule->url->stryng->str);
-                    import_rule->sheet = parse_stylesheet (file, NULL);
-                  }
-
-                if (import_rule->sheet)
-                  {
-                    insert_stylesheet (a_this, file, import_rule->sheet);
-                    /* refcount of stylesheets starts off at zero, so we don't need to unref! */
-                  }
-                else
-                  {
-                    /* Set a marker to avoid repeatedly trying to parse a non-existent or
-                     * broken stylesheet
-                     */
-                    import_rule->sheet = (CRStyleSheet *) - 1;
-                  }
-
-                if (file)
-                  g_object_unref (file);
-              }
-
-            if (import_rule->sheet != (CRStyleSheet *) - 1)
-              {
-                add_matched_properties (a_this, import_rule->sheet,
-                                        a_node, props);
-              }
-          }
-          break;
-        case AT_RULE_STMT:
-        case AT_PAGE_RULE_STMT:
-        case AT_CHARSET_RULE_STMT:
-        case AT_FONT_FACE_RULE_STMT:
-        default:
-          break;
+          continue;
         }
 
-      if (!sel_list)
-        continue;
+      status = sel_matches_style_real (a_this, cur_sel->simple_sel, a_node, &matches, TRUE, TRUE);
 
-      /*
-       *now, we have a comma separated selector list to look in.
-       *let's walk it and try to match the style node
-       *on each item of the list.
-       */
-      for (cur_sel = sel_list; cur_sel; cur_sel = cur_sel->next)
+      if (status == CR_OK && matches)
         {
-          if (!cur_sel->simple_sel)
-            continue;
+          CRDeclaration *cur_decl = NULL;
+
+          /* In order to sort the matching properties, we need to compute the
+           * specificity of the selector that actually matched this
+           * element. In a non-thread-safe fashion, we store it in the
+           * ruleset. (Fixing this would mean cut-and-pasting
+           * cr_simple_sel_compute_specificity(), and have no need for
+           * thread-safety anyways.)
+           *
+           * Once we've sorted the properties, the specificity no longer
+           * matters and it can be safely overriden.
+           */
+          cr_simple_sel_compute_specificity (cur_sel->simple_sel);
 
-          status = sel_matches_style_real (a_this, cur_sel->simple_sel, a_node, &matches, TRUE, TRUE);
+          cur_stmt->specificity = cur_sel->simple_sel->specificity;
 
-          if (status == CR_OK && matches)
-            {
-              CRDeclaration *cur_decl = NULL;
-
-              /* In order to sort the matching properties, we need to compute the
-               * specificity of the selector that actually matched this
-               * element. In a non-thread-safe fashion, we store it in the
-               * ruleset. (Fixing this would mean cut-and-pasting
-               * cr_simple_sel_compute_specificity(), and have no need for
-               * thread-safety anyways.)
-               *
-               * Once we've sorted the properties, the specificity no longer
-               * matters and it can be safely overriden.
-               */
-              cr_simple_sel_compute_specificity (cur_sel->simple_sel);
-
-              cur_stmt->specificity = cur_sel->simple_sel->specificity;
-
-              for (cur_decl = cur_stmt->kind.ruleset->decl_list; cur_decl; cur_decl = cur_decl->next)
-                g_ptr_array_add (props, cur_decl);
-            }
+          for (cur_decl = cur_stmt->kind.ruleset->decl_list; cur_decl; cur_decl = cur_decl->next)
+            g_ptr_array_add (props, cur_decl);
         }
     }
+
+  g_array_unref (candidates);
 }
 
 #define ORIGIN_OFFSET_IMPORTANT (NB_ORIGINS)
@@ -1026,6 +1266,160 @@ _st_theme_get_matched_properties (StTheme        *theme,
   return props;
 }
 
+#define MAX_CACHED_MATCHES 4096
+
+static guint
+strv_hash (GStrv strv)
+{
+  guint hash = 0;
+
+  for (; strv && *strv; strv++)
+    hash = hash * 33 + g_str_hash (*strv) + 1;
+
+  return hash;
+}
+
+static gboolean
+strv_equal (GStrv strv_a,
+            GStrv strv_b)
+{
+  if (strv_a == NULL || strv_b == NULL)
+    return (strv_a == NULL || *strv_a == NULL) && (strv_b == NULL || *strv_b == NULL);
+
+  for (; *strv_a && *strv_b; strv_a++, strv_b++)
+    {
+      if (strcmp (*strv_a, *strv_b) != 0)
+        return FALSE;
+    }
+
+  return *strv_a == *strv_b;
+}
+
+static guint
+match_hash (gconstpointer key)
+{
+  const StThemeMatch *match = key;
+
+  return match->hash;
+}
+
+static gboolean
+match_equal (gconstpointer a,
+             gconstpointer b)
+{
+  const StThemeMatch *match_a = a;
+  const StThemeMatch *match_b = b;
+
+  return match_a->parent == match_b->parent &&
+         match_a->element_type == match_b->element_type &&
+         g_strcmp0 (match_a->element_id, match_b->element_id) == 0 &&
+         strv_equal (match_a->element_classes, match_b->element_classes) &&
+         strv_equal (match_a->pseudo_classes, match_b->pseudo_classes);
+}
+
+/**
+ * _st_theme_match_node:
+ * @theme: a #StTheme
+ * @node: the node to match
+ * @parent_match: (nullable): the match of the parent of @node
+ *
+ * Returns the declarations of @theme matching @node, sorted like
+ * _st_theme_get_matched_properties() does. Rules only look at the element
+ * type, id, classes and pseudo-classes of a node and of its ancestors, so
+ * the result is looked up in a cache keyed by these and @parent_match.
+ *
+ * Returns: (transfer full): the match of @node
+ */
+StThemeMatch *
+_st_theme_match_node (StTheme      *theme,
+                      StThemeNode  *node,
+                      StThemeMatch *parent_match)
+{
+  StThemeMatch key = { 0, };
+  StThemeMatch *match;
+  GPtrArray *props;
+  gboolean cacheable;
+
+  g_return_val_if_fail (ST_IS_THEME (theme), NULL);
+  g_return_val_if_fail (ST_IS_THEME_NODE (node), NULL);
+
+  /* a match from another theme or from before a stylesheet change does
+   * not identify the ancestors of node for this theme */
+  if (parent_match != NULL)
+    cacheable = parent_match->theme == theme && parent_match->generation == theme->generation;
+  else
+    cacheable = st_theme_node_get_parent (node) == NULL;
+
+  key.parent = cacheable ? parent_match : NULL;
+  key.element_type = st_theme_node_get_element_type (node);
+  key.element_id = (char *) st_theme_node_get_element_id (node);
+  key.element_classes = st_theme_node_get_element_classes (node);
+  key.pseudo_classes = st_theme_node_get_pseudo_classes (node);
+
+  key.hash = GPOINTER_TO_UINT (key.parent);
+  key.hash = key.hash * 33 + (guint) key.element_type;
+  if (key.element_id)
+    key.hash = key.hash * 33 + g_str_hash (key.element_id);
+  key.hash = key.hash * 33 + strv_hash (key.element_classes);
+  key.hash = key.hash * 33 + strv_hash (key.pseudo_classes);
+
+  if (cacheable)
+    {
+      match = g_hash_table_lookup (theme->matches, &key);
+      if (match)
+        return _st_theme_match_ref (match);
+    }
+
+  props = _st_theme_get_matched_properties (theme, node);
+
+  match = g_new0 (StThemeMatch, 1);
+  match->ref_count = 1;
+  match->theme = theme;
+  match->generation = theme->generation;
+  match->hash = key.hash;
+  /* keeps the parent address from being reused by another match */
+  match->parent = key.parent ? _st_theme_match_ref (key.parent) : NULL;
+  match->element_type = key.element_type;
+  match->element_id = g_strdup (key.element_id);
+  match->element_classes = g_strdupv (key.element_classes);
+  match->pseudo_classes = g_strdupv (key.pseudo_classes);
+  match->n_properties = props->len;
+  match->properties = (CRDeclaration **) g_ptr_array_free (props, FALSE);
+
+  if (cacheable)
+    {
+      if (g_hash_table_size (theme->matches) >= MAX_CACHED_MATCHES)
+        g_hash_table_remove_all (theme->matches);
+
+      g_hash_table_add (theme->matches, _st_theme_match_ref (match));
+    }
+
+  return match;
+}
+
+StThemeMatch *
+_st_theme_match_ref (StThemeMatch *match)
+{
+  match->ref_count++;
+  return match;
+}
+
+void
+_st_theme_match_unref (StThemeMatch *match)
+{
+  if (--match->ref_count > 0)
+    return;
+
+  if (match->parent)
+    _st_theme_match_unref (match->parent);
+
+  g_free (match->element_id);
+  g_strfreev (match->element_classes);
+  g_strfreev (match->pseudo_classes);
+  g_free (match->properties);
+  g_free (match);
+}
+
 /* Resolve an url from an url() reference in a stylesheet into a GFile,
  * if possible. The resolution here is distinctly lame and
  * will fail on many examples.
@@ -0,0 +1,200 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * test-theme-benchmark.c: time CSS rule matching over the shell stylesheet
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * usage: test-theme-benchmark [gnome-shell.css]
+ */
+
+#include <clutter/clutter.h>
+#include "st-theme.h"
+#include "st-theme-context.h"
+#include "st-theme-private.h"
+#include "st-bin.h"
+#include "st-box-layout.h"
+#include "st-button.h"
+#include "st-entry.h"
+#include "st-icon.h"
+#include "st-label.h"
+#include "st-scroll-bar.h"
+#include "st-scroll-view.h"
+
+/* A widget tree looking like the top bar, the overview app grid and a
+ * popup menu; parent is an index in the same table, -1 for the node the
+ * table is added under.
+ * The grid icons and menu items are repeated to give lists of realistic
+ * size.
+ */
+typedef struct {
+  int parent;
+  GType (*get_type) (void);
+  const char *id;
+  const char *classes;
+  const char *pseudo_classes;
+} BenchmarkNode;
+
+static const BenchmarkNode panel_nodes[] = {
+  { -1, st_widget_get_type,      "panel",        NULL,                NULL },
+  {  0, st_box_layout_get_type,  "panelLeft",    NULL,                NULL },
+  {  1, st_bin_get_type,         NULL,           "panel-button",      NULL },
+  {  2, st_label_get_type,       NULL,           NULL,                NULL },
+  {  0, st_box_layout_get_type,  "panelCenter",  NULL,                NULL },
+  {  4, st_bin_get_type,         NULL,           "panel-button",      "hover" },
+  {  5, st_label_get_type,       NULL,           "clock",             NULL },
+  {  0, st_box_layout_get_type,  "panelRight",   NULL,                NULL },
+  {  7, st_bin_get_type,         NULL,           "panel-button",      NULL },
+  {  8, st_icon_get_type,        NULL,           "system-status-icon", NULL },
+};
+
+static const BenchmarkNode grid_nodes[] = {
+  { -1, st_widget_get_type,      "overview",     NULL,                NULL },
+  {  0, st_entry_get_type,       "searchEntry",  "search-entry",      "focus" },
+  {  0, st_scroll_view_get_type, NULL,           "all-apps vfade",    NULL },
+  {  2, st_scroll_bar_get_type,  NULL,           NULL,                NULL },
+  {  2, st_widget_get_type,      NULL,           "icon-grid",         NULL },
+};
+
+static const BenchmarkNode grid_icon_nodes[] = {
+  { -1, st_button_get_type,      NULL,           "app-well-app",      NULL },
+  {  0, st_widget_get_type,      NULL,           "overview-icon",     NULL },
+  {  1, st_box_layout_get_type,  NULL,           NULL,                NULL },
+  {  2, st_icon_get_type,        NULL,           NULL,                NULL },
+  {  2, st_label_get_type,       NULL,           NULL,                NULL },
+};
+
+static const BenchmarkNode menu_nodes[] = {
+  { -1, st_bin_get_type,         NULL,           "popup-menu-boxpointer", NULL },
+  {  0, st_widget_get_type,      NULL,           "popup-menu",        NULL },
+  {  1, st_box_layout_get_type,  NULL,           "popup-menu-content", NULL },
+};
+
+static const BenchmarkNode menu_item_nodes[] = {
+  { -1, st_box_layout_get_type,  NULL,           "popup-menu-item",   NULL },
+  {  0, st_icon_get_type,        NULL,           "popup-menu-icon",   NULL },
+  {  0, st_label_get_type,       NULL,           NULL,                NULL },
+};
+
+#define N_GRID_ICONS 48
+#define N_MENU_ITEMS 24
+#define MIN_DURATION (G_USEC_PER_SEC / 2)
+
+static void
+add_nodes (GPtrArray           *nodes,
+           StThemeContext      *context,
+           StThemeNode         *parent_node,
+           const BenchmarkNode *spec,
+           int                  n_spec,
+           gboolean             hover)
+{
+  StThemeNode **created = g_newa (StThemeNode *, n_spec);
+  int i;
+
+  for (i = 0; i < n_spec; i++)
+    {
+      StThemeNode *parent = spec[i].parent < 0 ? parent_node : created[spec[i].parent];
+      const char *pseudo_classes = spec[i].pseudo_classes;
+
+      if (hover && spec[i].parent < 0)
+        pseudo_classes = "hover";
+
+      created[i] = st_theme_node_new (context, parent, NULL,
+                                      spec[i].get_type (),
+                                      spec[i].id,
+                                      spec[i].classes,
+                                      pseudo_classes,
+                                      NULL);
+      g_ptr_array_add (nodes, created[i]);
+    }
+}
+
+/* Match every node until at least MIN_DURATION passed; returns the
+ * average time per node in microseconds
+ */
+static double
+run (StTheme   *theme,
+     GPtrArray *nodes)
+{
+  gint64 start = g_get_monotonic_time ();
+  gint64 elapsed;
+  int iterations = 0;
+  guint i;
+
+  do
+    {
+      for (i = 0; i < nodes->len; i++)
+        g_ptr_array_free (_st_theme_get_matched_properties (theme, nodes->pdata[i]), TRUE);
+
+      iterations++;
+      elapsed = g_get_monotonic_time () - start;
+    }
+  while (elapsed < MIN_DURATION);
+
+  return (double) elapsed / iterations / nodes->len;
+}
+
+int
+main (int argc, char **argv)
+{
+  StTheme *theme;
+  StThemeContext *context;
+  StThemeNode *root;
+  StThemeNode *parent;
+  ClutterActor *stage;
+  GPtrArray *nodes;
+  GFile *file;
+  gint64 start;
+  gint64 load_time;
+  int i;
+
+  gtk_init (&argc, &argv);
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  file = g_file_new_for_path (argc > 1 ? argv[1] : ST_BENCHMARK_STYLESHEET);
+  start = g_get_monotonic_time ();
+  theme = st_theme_new (NULL, file, NULL);
+  load_time = g_get_monotonic_time () - start;
+  g_object_unref (file);
+
+  stage = clutter_stage_new ();
+  context = st_theme_context_get_for_stage (CLUTTER_STAGE (stage));
+  st_theme_context_set_theme (context, theme);
+  root = st_theme_context_get_root_node (context);
+
+  nodes = g_ptr_array_new_with_free_func (g_object_unref);
+  g_ptr_array_add (nodes, g_object_ref (root));
+
+  add_nodes (nodes, context, root, panel_nodes, G_N_ELEMENTS (panel_nodes), FALSE);
+  add_nodes (nodes, context, root, grid_nodes, G_N_ELEMENTS (grid_nodes), FALSE);
+  parent = nodes->pdata[nodes->len - 1];
+  for (i = 0; i < N_GRID_ICONS; i++)
+    add_nodes (nodes, context, parent, grid_icon_nodes, G_N_ELEMENTS (grid_icon_nodes), i == 0);
+
+  add_nodes (nodes, context, root, menu_nodes, G_N_ELEMENTS (menu_nodes), FALSE);
+  parent = nodes->pdata[nodes->len - 1];
+  for (i = 0; i < N_MENU_ITEMS; i++)
+    add_nodes (nodes, context, parent, menu_item_nodes, G_N_ELEMENTS (menu_item_nodes), i == 0);
+
+  g_print ("%-24s %12.3f ms\n", "load", load_time / 1000.0);
+  g_print ("%-24s %12u\n", "nodes", nodes->len);
+  g_print ("%-24s %12.3f us\n", "match (per node)", run (theme, nodes));
+
+  g_ptr_array_unref (nodes);
+  g_object_unref (theme);
+  clutter_actor_destroy (stage);
+
+  return 0;
+}